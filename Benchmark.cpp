@@ -0,0 +1,254 @@
+// Benchmarks for the tournament engine.
+//
+//     g++ -std=c++17 -O2 -pthread Benchmark.cpp -o benchmark
+//     ./benchmark [--sizes 1000,10000,100000,1000000] [--ops 100000]
+//                 [--dir bench_data] [--out bench.json] [--label name]
+//
+// For every roster size a synthetic player.csv / wildcard.csv pair is generated,
+// then each operation is timed on its own. Per-call operations report latency
+// percentiles; whole-roster operations (load, status update, save) are timed as a
+// single run. Results go to a JSON file so runs can be compared between versions.
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include "RegistrationPipeline.hpp"
+
+#ifdef _WIN32
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+struct BenchResult {
+    size_t rosterSize;
+    string operation;
+    size_t ops;
+    double seconds;
+    long long p50, p90, p99, maxNs;   // per-call latency, 0 for single runs
+    long long peakRssKb;
+};
+
+long long peakRssKb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return (long long)(counters.PeakWorkingSetSize / 1024);
+    }
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;   // kilobytes on Linux
+#endif
+}
+
+long long elapsedNs(Clock::time_point start) {
+    return chrono::duration_cast<chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+// Write size players and size/10 wildcards in the same shape as the real files
+void generateRoster(size_t size, const string& playerFile, const string& wildcardFile) {
+    static const char* universities[] = {"APU", "Monash", "UM", "Taylors", "Sunway", "UTM", "USM", "UPM"};
+    mt19937_64 rng(size);
+    time_t start = parseTime("2025-05-19 00:00:00");
+
+    FILE* players = fopen(playerFile.c_str(), "wb");
+    for (size_t i = 0; i < size; ++i) {
+        fprintf(players, "%zu,player%llu,%d,%s,%d,%s,%d,0\n", 1000 + i,
+                (unsigned long long)(rng() % (size / 4 + 1)), (int)(rng() % 100) + 1,
+                universities[rng() % 8], (int)(rng() % 2),
+                formatTime(start + (time_t)(rng() % (14 * 24 * 3600))).c_str(), rng() % 20 == 0 ? 1 : 0);
+    }
+    fclose(players);
+
+    FILE* wildcards = fopen(wildcardFile.c_str(), "wb");
+    for (size_t i = 0; i < size / 10 + 1; ++i) {
+        fprintf(wildcards, "WC%zu,guest%zu,%d,%s,0\n", i, i, (int)(rng() % 100) + 1, universities[rng() % 8]);
+    }
+    fclose(wildcards);
+}
+
+BenchResult summarize(size_t size, const string& operation, vector<long long>& samples, double seconds) {
+    BenchResult r = {size, operation, samples.size(), seconds, 0, 0, 0, 0, peakRssKb()};
+    if (!samples.empty()) {
+        sort(samples.begin(), samples.end());
+        auto at = [&](double q) { return samples[min(samples.size() - 1, (size_t)(q * samples.size()))]; };
+        r.p50 = at(0.50);
+        r.p90 = at(0.90);
+        r.p99 = at(0.99);
+        r.maxNs = samples.back();
+    }
+    return r;
+}
+
+BenchResult single(size_t size, const string& operation, size_t rows, long long ns) {
+    BenchResult r = {size, operation, rows, ns / 1e9, 0, 0, 0, 0, peakRssKb()};
+    return r;
+}
+
+// Time body(i) for i in [0, ops) one call at a time
+template <typename Body>
+BenchResult perCall(size_t size, const string& operation, size_t ops, Body body) {
+    vector<long long> samples;
+    samples.reserve(ops);
+    Clock::time_point all = Clock::now();
+    for (size_t i = 0; i < ops; ++i) {
+        Clock::time_point start = Clock::now();
+        body(i);
+        samples.push_back(elapsedNs(start));
+    }
+    double seconds = elapsedNs(all) / 1e9;
+    return summarize(size, operation, samples, seconds);
+}
+
+void runSize(size_t size, size_t maxOps, const string& dir, vector<BenchResult>& results) {
+    string playerFile = dir + "/player_" + to_string(size) + ".csv";
+    string wildcardFile = dir + "/wildcard_" + to_string(size) + ".csv";
+    string saveFile = dir + "/saved_" + to_string(size) + ".csv";
+    generateRoster(size, playerFile, wildcardFile);
+    size_t ops = min(size, maxOps);
+
+    CircularQueue queue;
+    WildcardQueue wildcards;
+
+    Clock::time_point start = Clock::now();
+    queue.loadFromCSV(playerFile);
+    results.push_back(single(size, "loadFromCSV", size, elapsedNs(start)));
+
+    start = Clock::now();
+    wildcards.loadFromCSV(wildcardFile);
+    results.push_back(single(size, "WildcardQueue::loadFromCSV", size / 10 + 1, elapsedNs(start)));
+
+    start = Clock::now();
+    queue.updateTournamentStatus();
+    results.push_back(single(size, "updateTournamentStatus", size, elapsedNs(start)));
+
+    mt19937_64 rng(42);
+    results.push_back(perCall(size, "checkIn", ops, [&](size_t) {
+        queue.checkIn(1000 + (int)(rng() % size));
+    }));
+
+    int firstNew = queue.getNextID();
+    results.push_back(perCall(size, "enqueue", ops, [&](size_t i) {
+        queue.enqueue("bench" + to_string(i), (int)(i % 100) + 1, "APU", i % 20 == 0);
+    }));
+
+    results.push_back(perCall(size, "withdraw", ops, [&](size_t i) {
+        queue.withdraw(firstNew + (int)i);
+    }));
+
+    size_t codes = min(ops, size / 10 + 1);
+    results.push_back(perCall(size, "redeemWildcard", codes, [&](size_t i) {
+        string username, university;
+        int rank;
+        wildcards.redeemWildcard("WC" + to_string(i), username, rank, university);
+    }));
+
+    start = Clock::now();
+    queue.saveAllToCSV(saveFile);
+    results.push_back(single(size, "saveAllToCSV", size, elapsedNs(start)));
+
+    // Producer latency of the ingestion pipeline with several desks registering at
+    // once; the applier's work shows up in the total time (which includes the flush)
+    ConcurrentCircularQueue shared;
+    shared.loadFromCSV(playerFile);
+    const size_t producers = 4;
+    vector<vector<long long>> perThread(producers);
+    start = Clock::now();
+    {
+        RegistrationPipeline pipeline(shared);
+        vector<thread> desks;
+        for (size_t t = 0; t < producers; ++t) {
+            desks.emplace_back([&, t]() {
+                perThread[t].reserve(ops / producers);
+                for (size_t i = t; i < ops; i += producers) {
+                    Clock::time_point call = Clock::now();
+                    pipeline.enqueue("rush" + to_string(i), (int)(i % 100) + 1, "APU", i % 20 == 0);
+                    perThread[t].push_back(elapsedNs(call));
+                }
+            });
+        }
+        for (thread& desk : desks) desk.join();
+        pipeline.flush();
+    }
+    vector<long long> samples;
+    for (const vector<long long>& part : perThread) samples.insert(samples.end(), part.begin(), part.end());
+    results.push_back(summarize(size, "pipelineEnqueue", samples, elapsedNs(start) / 1e9));
+
+    remove(playerFile.c_str());
+    remove(wildcardFile.c_str());
+    remove(saveFile.c_str());
+}
+
+void writeJson(FILE* out, const string& label, const vector<BenchResult>& results) {
+    fprintf(out, "{\n  \"label\": \"%s\",\n  \"timestamp\": \"%s\",\n  \"results\": [\n",
+            label.c_str(), formatTime(time(0)).c_str());
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        fprintf(out,
+                "    {\"roster_size\": %zu, \"operation\": \"%s\", \"ops\": %zu, \"seconds\": %.6f, "
+                "\"throughput_per_sec\": %.1f, \"p50_ns\": %lld, \"p90_ns\": %lld, \"p99_ns\": %lld, "
+                "\"max_ns\": %lld, \"peak_rss_kb\": %lld}%s\n",
+                r.rosterSize, r.operation.c_str(), r.ops, r.seconds,
+                r.seconds > 0 ? r.ops / r.seconds : 0.0, r.p50, r.p90, r.p99, r.maxNs, r.peakRssKb,
+                i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+int main(int argc, char** argv) {
+    vector<size_t> sizes = {1000, 10000, 100000, 1000000};
+    size_t maxOps = 100000;
+    string dir = ".", outFile = "bench.json", label = "dev";
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string flag = argv[i], value = argv[i + 1];
+        if (flag == "--sizes") {
+            sizes.clear();
+            stringstream ss(value);
+            string item;
+            while (getline(ss, item, ',')) sizes.push_back(stoull(item));
+        } else if (flag == "--ops") {
+            maxOps = stoull(value);
+        } else if (flag == "--dir") {
+            dir = value;
+        } else if (flag == "--out") {
+            outFile = value;
+        } else if (flag == "--label") {
+            label = value;
+        } else {
+            fprintf(stderr, "Unknown option %s\n", flag.c_str());
+            return 1;
+        }
+    }
+
+    // The queues report every operation on cout; keep that out of the timings
+    streambuf* console = cout.rdbuf(nullptr);
+
+    vector<BenchResult> results;
+    for (size_t size : sizes) {
+        fprintf(stderr, "roster %zu...\n", size);
+        runSize(size, maxOps, dir, results);
+    }
+    cout.rdbuf(console);
+    cout.clear();
+
+    for (const BenchResult& r : results) {
+        fprintf(stderr, "%9zu  %-28s %10zu ops %10.4f s  p50 %8lld ns  p99 %9lld ns\n",
+                r.rosterSize, r.operation.c_str(), r.ops, r.seconds, r.p50, r.p99);
+    }
+
+    FILE* out = fopen(outFile.c_str(), "w");
+    if (!out) {
+        fprintf(stderr, "Cannot write %s\n", outFile.c_str());
+        return 1;
+    }
+    writeJson(out, label, results);
+    fclose(out);
+    fprintf(stderr, "Results written to %s (peak RSS %lld KB)\n", outFile.c_str(), peakRssKb());
+    return 0;
+}
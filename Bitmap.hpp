@@ -0,0 +1,199 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+// Dense bitset over slot numbers, grown on demand. Used for the roster's secondary
+// indexes (one bit per player slot), where set algebra and counting run a word
+// (64 players) at a time.
+//
+// setShared() may run while other threads read the same bitmap (check-ins under a
+// reader lock), so every read of a word is a relaxed atomic load; on x86 and ARM
+// that is an ordinary load. Everything that resizes or clears bits still needs the
+// bitmap to itself.
+class Bitmap {
+private:
+    vector<uint64_t> words;
+
+    static uint64_t load(const uint64_t& word) {
+#if defined(_MSC_VER)
+        return *(const volatile uint64_t*)&word;
+#else
+        return __atomic_load_n(&word, __ATOMIC_RELAXED);
+#endif
+    }
+
+    static int popcount(uint64_t word) {
+#if defined(_MSC_VER)
+        return (int)__popcnt64(word);
+#else
+        return __builtin_popcountll(word);
+#endif
+    }
+
+    static int lowestBit(uint64_t word) {
+#if defined(_MSC_VER)
+        unsigned long bit;
+        _BitScanForward64(&bit, word);
+        return (int)bit;
+#else
+        return __builtin_ctzll(word);
+#endif
+    }
+
+public:
+    Bitmap() {}
+    Bitmap(const Bitmap& other) : words(other.words.size()) {
+        for (size_t i = 0; i < words.size(); ++i) words[i] = load(other.words[i]);
+    }
+    Bitmap(Bitmap&& other) = default;
+    Bitmap& operator=(const Bitmap& other) {
+        if (this != &other) {
+            words.resize(other.words.size());
+            for (size_t i = 0; i < words.size(); ++i) words[i] = load(other.words[i]);
+        }
+        return *this;
+    }
+    Bitmap& operator=(Bitmap&& other) = default;
+
+    size_t wordCount() const { return words.size(); }
+
+    // Make room for bits [0, bits) without changing any of them
+    void reserve(size_t bits) {
+        if ((bits + 63) / 64 > words.size()) words.resize((bits + 63) / 64, 0);
+    }
+
+    void set(size_t bit) {
+        reserve(bit + 1);
+        words[bit >> 6] |= 1ULL << (bit & 63);
+    }
+
+    // set() for a bit whose word other threads may be setting at the same time.
+    // The word must already exist (see reserve).
+    void setShared(size_t bit) {
+#if defined(_MSC_VER)
+        _InterlockedOr64((volatile long long*)&words[bit >> 6], (long long)(1ULL << (bit & 63)));
+#else
+        __atomic_fetch_or(&words[bit >> 6], 1ULL << (bit & 63), __ATOMIC_RELAXED);
+#endif
+    }
+
+    void reset(size_t bit) {
+        if ((bit >> 6) < words.size()) words[bit >> 6] &= ~(1ULL << (bit & 63));
+    }
+
+    void assign(size_t bit, bool value) {
+        if (value) {
+            set(bit);
+        } else {
+            reset(bit);
+        }
+    }
+
+    bool test(size_t bit) const {
+        return (bit >> 6) < words.size() && (load(words[bit >> 6]) >> (bit & 63)) & 1;
+    }
+
+    void clear() { words.clear(); }
+
+    size_t count() const {
+        size_t total = 0;
+        for (const uint64_t& word : words) total += popcount(load(word));
+        return total;
+    }
+
+    bool empty() const {
+        for (const uint64_t& word : words) {
+            if (load(word)) return false;
+        }
+        return true;
+    }
+
+    // visit(bit) for every set bit, lowest first
+    template <typename Visitor>
+    void forEach(Visitor visit) const {
+        for (size_t i = 0; i < words.size(); ++i) {
+            for (uint64_t word = load(words[i]); word; word &= word - 1) visit(i * 64 + lowestBit(word));
+        }
+    }
+
+    Bitmap& operator&=(const Bitmap& other) {
+        if (words.size() > other.words.size()) words.resize(other.words.size());
+        for (size_t i = 0; i < words.size(); ++i) words[i] &= load(other.words[i]);
+        return *this;
+    }
+
+    Bitmap& operator|=(const Bitmap& other) {
+        reserve(other.words.size() * 64);
+        for (size_t i = 0; i < other.words.size(); ++i) words[i] |= load(other.words[i]);
+        return *this;
+    }
+
+    // Difference: keep only the bits not set in other (AND NOT)
+    Bitmap& operator-=(const Bitmap& other) {
+        size_t shared = words.size() < other.words.size() ? words.size() : other.words.size();
+        for (size_t i = 0; i < shared; ++i) words[i] &= ~load(other.words[i]);
+        return *this;
+    }
+
+    friend Bitmap operator&(Bitmap a, const Bitmap& b) { return a &= b; }
+    friend Bitmap operator|(Bitmap a, const Bitmap& b) { return a |= b; }
+    friend Bitmap operator-(Bitmap a, const Bitmap& b) { return a -= b; }
+};
+
+// Grow-only set of non-negative integers (player IDs) that any number of threads
+// can add to and test at once without locks. Bits live in 128 KiB chunks that are
+// allocated on first use and never move, so every bit is one atomic word away.
+class AtomicBitSet {
+private:
+    static const int ChunkShift = 20;                   // 2^20 bits per chunk
+    static const size_t ChunkWords = (size_t(1) << ChunkShift) / 64;
+    static const size_t MaxChunks = size_t(1) << (31 - ChunkShift);
+
+    atomic<atomic<uint64_t>*> chunks[MaxChunks];
+
+    atomic<uint64_t>* chunkOf(int value, bool create) {
+        atomic<uint64_t>* chunk = chunks[value >> ChunkShift].load(memory_order_acquire);
+        if (chunk || !create) return chunk;
+        atomic<uint64_t>* fresh = new atomic<uint64_t>[ChunkWords];
+        for (size_t i = 0; i < ChunkWords; ++i) fresh[i].store(0, memory_order_relaxed);
+        if (chunks[value >> ChunkShift].compare_exchange_strong(chunk, fresh, memory_order_acq_rel)) return fresh;
+        delete[] fresh;     // another thread got there first
+        return chunk;
+    }
+
+    static uint64_t maskOf(int value) { return 1ULL << (value & 63); }
+    static size_t wordOf(int value) { return (size_t)(value & ((1 << ChunkShift) - 1)) >> 6; }
+
+public:
+    AtomicBitSet() {
+        for (size_t i = 0; i < MaxChunks; ++i) chunks[i].store(nullptr, memory_order_relaxed);
+    }
+    ~AtomicBitSet() {
+        for (size_t i = 0; i < MaxChunks; ++i) delete[] chunks[i].load(memory_order_relaxed);
+    }
+
+    AtomicBitSet(const AtomicBitSet&) = delete;
+    AtomicBitSet& operator=(const AtomicBitSet&) = delete;
+
+    // Add value; true if it was not in the set before
+    bool insert(int value) {
+        if (value < 0) return false;
+        uint64_t before = chunkOf(value, true)[wordOf(value)].fetch_or(maskOf(value), memory_order_release);
+        return (before & maskOf(value)) == 0;
+    }
+
+    bool contains(int value) const {
+        if (value < 0) return false;
+        atomic<uint64_t>* chunk = const_cast<AtomicBitSet*>(this)->chunkOf(value, false);
+        return chunk && (chunk[wordOf(value)].load(memory_order_acquire) & maskOf(value)) != 0;
+    }
+};
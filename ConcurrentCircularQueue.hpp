@@ -0,0 +1,241 @@
+#pragma once
+
+#include <shared_mutex>
+#include "RosterVersions.hpp"
+#include "Task2.hpp"
+
+// Thread-safe CircularQueue for serving several registration desks from one process.
+// Registration, withdrawal and edits take the writer lock. A check-in takes no lock
+// at all: it finds the player in the current roster version, marks them there (see
+// RosterVersions::View::checkIn) and leaves their ID on a lock-free list. The next
+// write applies that list to the live players (and their journal, if one is
+// attached), so check-ins never wait for registrations, withdrawals, publishing or
+// readers. read() sees only check-ins applied so far.
+//
+// Every change also publishes a new copy-on-write version of the roster
+// (RosterVersions.hpp), and everything that only reads goes there instead of the
+// live queue: listings and CSV exports walk a pinned version, and exists and
+// displayPlayer look the player up in one. None of them take a lock, so readers
+// run in parallel with each other and never wait for registrations or publishing.
+class ConcurrentCircularQueue {
+public:
+    typedef RosterVersions<WildcardThenTime> Versions;
+
+private:
+    CircularQueue queue;
+    mutable shared_mutex lock;
+    Versions versions;
+    vector<int> moved;      // players whose slot changed in the current write
+
+    struct PendingCheckIn {
+        int playerID;
+        uint64_t loaded;        // roster reload the player was found in
+        PendingCheckIn* next;
+    };
+    atomic<PendingCheckIn*> pendingCheckIns{nullptr};   // not yet in the live queue
+
+    // Apply the check-ins taken since the last call to the live queue, except those
+    // for players of a roster reloaded since. Writer lock held.
+    void applyCheckIns() {
+        PendingCheckIn* list = pendingCheckIns.exchange(nullptr, memory_order_acquire);
+        uint64_t loaded = versions.loaded();
+        while (list) {
+            if (list->loaded == loaded) queue.markCheckedIn(list->playerID);
+            PendingCheckIn* next = list->next;
+            delete list;
+            list = next;
+        }
+    }
+
+    // Publish the players a write changed, plus everyone it moved across the slot
+    // line. Called with the writer lock held.
+    void publish(vector<int> changed) {
+        changed.insert(changed.end(), moved.begin(), moved.end());
+        moved.clear();
+        versions.refresh(changed, [this](int id) { return queue.find(id); });
+    }
+
+    // Publish the whole roster again, for bulk changes. Writer lock held.
+    void republish(bool reload = false) {
+        moved.clear();
+        versions.rebuild([this](auto visit) { queue.forEachPlayer(visit); }, reload);
+    }
+
+public:
+    ConcurrentCircularQueue() {
+        queue.setAdmissionListener([this](const AdmissionEvent& e) { moved.push_back(e.playerID); });
+    }
+
+    ~ConcurrentCircularQueue() {
+        for (PendingCheckIn* p = pendingCheckIns.load(); p;) {
+            PendingCheckIn* next = p->next;
+            delete p;
+            p = next;
+        }
+    }
+
+    ConcurrentCircularQueue(const ConcurrentCircularQueue&) = delete;
+    ConcurrentCircularQueue& operator=(const ConcurrentCircularQueue&) = delete;
+
+    void loadFromCSV(const string& filename) {
+        unique_lock<shared_mutex> guard(lock);
+        applyCheckIns();
+        queue.loadFromCSV(filename);
+        republish(true);
+    }
+
+    void saveAllToCSV(const string& filename) {
+        Versions::View roster = versions.pin();
+        ofstream file(filename, ios::trunc);
+        if (!file.is_open()) return;
+        roster.writeCSV(file);
+    }
+
+    void writeCSV(ostream& file) {
+        versions.pin().writeCSV(file);
+    }
+
+    int enqueue(string username, int rank, string university, bool isWildcard = false) {
+        unique_lock<shared_mutex> guard(lock);
+        applyCheckIns();
+        int id = queue.enqueue(username, rank, university, isWildcard);
+        publish({id});
+        return id;
+    }
+
+    BatchResult enqueueBatch(const vector<Registration>& batch) {
+        unique_lock<shared_mutex> guard(lock);
+        applyCheckIns();
+        BatchResult result = queue.enqueueBatch(batch);
+        if ((size_t)result.count * 8 > queue.countOf(PlayerView::All)) {
+            republish();
+        } else {
+            vector<int> added;
+            int assigned = result.firstID;
+            for (const Registration& r : batch) added.push_back(r.playerID ? r.playerID : assigned++);
+            publish(added);
+        }
+        return result;
+    }
+
+    void display() {
+        Versions::View roster = versions.pin();
+        if (roster.size() == 0) {
+            cout << "No players in queue.\n";
+            return;
+        }
+        roster.display(cout, PlayerView::All, 0, (size_t)-1);
+    }
+
+    void display(PlayerView view, size_t offset, size_t limit, OutputFormat format = OutputFormat::Table) {
+        versions.pin().display(cout, view, offset, limit, format);
+    }
+
+    // A consistent copy of the roster as of now, for reports on any thread. It
+    // stays valid, and unchanged, until the View is destroyed.
+    Versions::View snapshot() const { return versions.pin(); }
+
+    void checkIn(int id) {
+        if (markCheckedIn(id)) {
+            cout << "Player ID " << id << " checked in.\n";
+        } else {
+            cout << "Player ID not found.\n";
+        }
+    }
+
+    // Lock-free; false if the player is not on the roster
+    bool markCheckedIn(int id) {
+        auto roster = versions.pin();
+        PlayerVersion record;
+        if (!roster.find(id, record)) return false;
+        if (record.checkInStatus) return true;
+        PendingCheckIn* entry = new PendingCheckIn{id, roster.loaded(), pendingCheckIns.load(memory_order_relaxed)};
+        while (!pendingCheckIns.compare_exchange_weak(entry->next, entry, memory_order_release,
+                                                      memory_order_relaxed)) {}
+        roster.checkIn(id);
+        return true;
+    }
+
+    void withdraw(int id) {
+        unique_lock<shared_mutex> guard(lock);
+        applyCheckIns();
+        queue.withdraw(id);
+        publish({id});
+    }
+
+    int getNextID() const { return queue.getNextID(); }
+
+    // Lock-free; see CircularQueue::reserveIDs
+    int reserveIDs(int count = 1) { return queue.reserveIDs(count); }
+
+    bool exists(int id) const {
+        PlayerVersion record;
+        return versions.find(id, record);
+    }
+
+    void displayPlayer(int id) const {
+        auto roster = versions.pin();   // holds the record's strings
+        PlayerVersion record;
+        if (roster.find(id, record)) {
+            writePlayerInfo(cout, &record);
+        } else if (roster.size() == 0) {
+            cout << "No players in queue.\n";
+        } else {
+            cout << "Player ID not found.\n";
+        }
+    }
+
+    // Prompts run without any lock held; only the final update takes the writer lock
+    void editPlayerInfo(int id) {
+        string username, university;
+        int rank;
+        {
+            shared_lock<shared_mutex> guard(lock);
+            const Player* p = queue.find(id);
+            if (!p) {
+                cout << "Player ID not found.\n";
+                return;
+            }
+            username = p->username->text;
+            rank = p->rank;
+            university = p->university->text;
+        }
+        CircularQueue::promptForEdits(username, rank, university);
+
+        unique_lock<shared_mutex> guard(lock);
+        applyCheckIns();
+        if (queue.updateInfo(id, username, rank, university)) {
+            publish({id});
+            cout << "Info updated successfully.\n";
+        } else {
+            cout << "Player ID not found.\n";
+        }
+    }
+
+    void updateTournamentStatus() {
+        unique_lock<shared_mutex> guard(lock);
+        applyCheckIns();
+        queue.updateTournamentStatus();
+        publish({});
+    }
+
+    // Run f(const CircularQueue&) under the reader lock, or f(CircularQueue&) under
+    // the writer lock, for anything the wrappers above do not cover
+    template <typename F>
+    auto read(F f) const -> decltype(f(queue)) {
+        shared_lock<shared_mutex> guard(lock);
+        return f(queue);
+    }
+
+    // (after which the whole roster is published again; reload through loadFromCSV)
+    template <typename F>
+    auto write(F f) -> decltype(f(queue)) {
+        unique_lock<shared_mutex> guard(lock);
+        struct Republish {
+            ConcurrentCircularQueue* self;
+            ~Republish() { self->republish(); }
+        } republishAfter{this};
+        applyCheckIns();
+        return f(queue);
+    }
+};
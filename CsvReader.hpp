@@ -0,0 +1,279 @@
+#pragma once
+
+#include <cctype>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CSV_USE_SSE2 1
+#endif
+
+using namespace std;
+
+// Read-only view of a whole file, memory-mapped so rows can be parsed in place
+class MappedFile {
+private:
+    const char* data = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+
+public:
+    MappedFile() {}
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const string& filename) {
+        close();
+#ifdef _WIN32
+        fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                 OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(fileHandle, &fileSize)) {
+            close();
+            return false;
+        }
+        length = (size_t)fileSize.QuadPart;
+        if (length == 0) return true;
+        mapping = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) {
+            close();
+            return false;
+        }
+        data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!data) {
+            close();
+            return false;
+        }
+#else
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        length = (size_t)st.st_size;
+        if (length > 0) {
+            void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                ::close(fd);
+                length = 0;
+                return false;
+            }
+            madvise(mapped, length, MADV_SEQUENTIAL);
+            data = (const char*)mapped;
+        }
+        ::close(fd);
+#endif
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+        mapping = nullptr;
+        fileHandle = INVALID_HANDLE_VALUE;
+#else
+        if (data) munmap((void*)data, length);
+#endif
+        data = nullptr;
+        length = 0;
+    }
+
+    const char* begin() const { return data; }
+    const char* end() const { return data + length; }
+    size_t size() const { return length; }
+};
+
+// Position of the first ',' or '\n' in [p, end), or end
+inline const char* findDelimiter(const char* p, const char* end) {
+#ifdef CSV_USE_SSE2
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i newline = _mm_set1_epi8('\n');
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)p);
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, comma),
+                                                  _mm_cmpeq_epi8(chunk, newline)));
+        if (mask) {
+#if defined(_MSC_VER)
+            unsigned long bit;
+            _BitScanForward(&bit, mask);
+            return p + bit;
+#else
+            return p + __builtin_ctz(mask);
+#endif
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && *p != ',' && *p != '\n') ++p;
+    return p;
+}
+
+// Same rules as stoi: optional leading spaces and sign, then at least one digit
+inline bool parseInt(string_view text, int& value) {
+    size_t i = 0;
+    while (i < text.size() && isspace((unsigned char)text[i])) ++i;
+    bool negative = false;
+    if (i < text.size() && (text[i] == '-' || text[i] == '+')) negative = (text[i++] == '-');
+    if (i >= text.size() || !isdigit((unsigned char)text[i])) return false;
+    long long result = 0;
+    for (; i < text.size() && isdigit((unsigned char)text[i]); ++i) {
+        result = result * 10 + (text[i] - '0');
+        if (result > 2147483648LL) return false;
+    }
+    if (negative) result = -result;
+    if (result > 2147483647LL) return false;
+    value = (int)result;
+    return true;
+}
+
+// Parse "YYYY-MM-DD HH:MM:SS" without allocating. mktime is only called about twice
+// per distinct date, whatever order the rows come in: local midnight is cached per
+// date, and the time of day is added to it. On days that are not 24 hours long
+// (daylight saving changes) each hour goes through mktime instead.
+inline bool parseTimeFast(string_view text, time_t& when) {
+    if (text.size() < 19) return false;
+    static const char pattern[] = "dddd-dd-dd dd:dd:dd";
+    for (int i = 0; i < 19; ++i) {
+        if (pattern[i] == 'd' ? !isdigit((unsigned char)text[i]) : text[i] != pattern[i]) return false;
+    }
+    for (size_t i = 19; i < text.size(); ++i) {
+        if (text[i] != '\r') return false;
+    }
+    auto digits = [&](int pos, int count) {
+        int v = 0;
+        for (int i = 0; i < count; ++i) v = v * 10 + (text[pos + i] - '0');
+        return v;
+    };
+    auto localTime = [](int year, int month, int day, int hour) {
+        struct tm t = {};
+        t.tm_year = year - 1900;
+        t.tm_mon = month - 1;
+        t.tm_mday = day;
+        t.tm_hour = hour;
+        t.tm_isdst = -1;
+        return mktime(&t);
+    };
+
+    struct Day {
+        int date = -1;          // year * 512 + month * 32 + day
+        time_t midnight = 0;
+        bool regular = false;   // exactly 24 hours long
+    };
+    thread_local Day cache[64];
+
+    int year = digits(0, 4), month = digits(5, 2), day = digits(8, 2), hour = digits(11, 2);
+    int date = year * 512 + month * 32 + day;
+    Day& cached = cache[date & 63];
+    if (cached.date != date) {
+        time_t midnight = localTime(year, month, day, 0);
+        if (midnight == (time_t)-1) return false;
+        cached.date = date;
+        cached.midnight = midnight;
+        cached.regular = localTime(year, month, day + 1, 0) - midnight == 86400;
+    }
+    time_t base = cached.regular ? cached.midnight + hour * 3600 : localTime(year, month, day, hour);
+    if (base == (time_t)-1) return false;
+    when = base + digits(14, 2) * 60 + digits(17, 2);
+    return true;
+}
+
+// Split [begin, end) into lines, drop a trailing '\r' and empty lines, split each
+// line on ',' and hand the fields to parseRow(fields, count, row). Rows it accepts
+// are appended to out in file order.
+template <typename Row, typename RowParser>
+void parseCsvRange(const char* begin, const char* end, RowParser parseRow, vector<Row>& out) {
+    const int MaxFields = 16;
+    string_view fields[MaxFields];
+    const char* p = begin;
+    while (p < end) {
+        int count = 0;
+        const char* fieldStart = p;
+        while (true) {
+            const char* delim = findDelimiter(p, end);
+            if (count < MaxFields) fields[count++] = string_view(fieldStart, delim - fieldStart);
+            p = delim;
+            if (p >= end || *p == '\n') break;
+            fieldStart = ++p;
+        }
+        if (p < end) ++p; // skip '\n'
+
+        string_view& last = fields[count - 1];
+        if (!last.empty() && last.back() == '\r') last.remove_suffix(1);
+        if (count == 1 && last.empty()) continue;
+
+        Row row;
+        if (parseRow(fields, count, row)) out.push_back(row);
+    }
+}
+
+// Parse a whole mapped file. Files above chunkBytes are cut at line boundaries
+// into one chunk per thread (hardware threads by default), parsed in parallel
+// and concatenated in order.
+template <typename Row, typename RowParser>
+vector<Row> parseCsvFile(const MappedFile& file, RowParser parseRow,
+                         size_t chunkBytes = 4 << 20, unsigned threads = 0) {
+    vector<Row> rows;
+    if (file.size() == 0) return rows;
+
+    if (threads == 0) threads = thread::hardware_concurrency();
+    if (threads < 2 || file.size() < chunkBytes) {
+        parseCsvRange(file.begin(), file.end(), parseRow, rows);
+        return rows;
+    }
+
+    vector<const char*> cuts(1, file.begin());
+    size_t step = file.size() / threads;
+    for (unsigned i = 1; i < threads; ++i) {
+        const char* cut = file.begin() + i * step;
+        if (cut <= cuts.back()) continue;
+        const char* newline = (const char*)memchr(cut, '\n', file.end() - cut);
+        if (!newline) break;
+        cuts.push_back(newline + 1);
+    }
+    cuts.push_back(file.end());
+
+    vector<vector<Row>> parts(cuts.size() - 1);
+    vector<thread> workers;
+    for (size_t i = 0; i + 1 < cuts.size(); ++i) {
+        workers.emplace_back([&, i]() { parseCsvRange(cuts[i], cuts[i + 1], parseRow, parts[i]); });
+    }
+    size_t total = 0;
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i].join();
+        total += parts[i].size();
+    }
+
+    rows.reserve(total);
+    for (auto& part : parts) rows.insert(rows.end(), part.begin(), part.end());
+    return rows;
+}
@@ -0,0 +1,283 @@
+#pragma once
+
+#include <cstdio>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "CsvReader.hpp"
+
+#ifdef _WIN32
+#include <io.h>
+#endif
+
+using namespace std;
+
+// Flush a stdio stream all the way to disk
+inline bool syncFile(FILE* file) {
+    if (fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Write contents to filename via a temp file, fsync it, then rename it over the
+// target so readers see either the old or the new file, never a partial one
+inline bool writeFileAtomically(const string& filename, const string& contents) {
+    string tempName = filename + ".tmp";
+    FILE* file = fopen(tempName.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+    ok = syncFile(file) && ok;
+    fclose(file);
+    if (!ok) {
+        remove(tempName.c_str());
+        return false;
+    }
+#ifdef _WIN32
+    return MoveFileExA(tempName.c_str(), filename.c_str(),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return rename(tempName.c_str(), filename.c_str()) == 0;
+#endif
+}
+
+inline bool fileExists(const string& filename) {
+    FILE* file = fopen(filename.c_str(), "rb");
+    if (!file) return false;
+    fclose(file);
+    return true;
+}
+
+// FNV-1a, used to detect torn or corrupted journal records
+inline unsigned int checksum(string_view text) {
+    unsigned int h = 2166136261u;
+    for (unsigned char c : text) {
+        h ^= c;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Append-only log of operations. Each record is one line of comma-separated fields
+// followed by '#' and a checksum:
+//     R,1021,NewGuy,3,UM,1760682886,0#3f2a9c01
+// Records are buffered and written + fsynced together once groupSize of them are
+// pending (group commit), or when commit() is called. Appending only takes the
+// buffer lock; the disk is touched under a separate lock, so a commit running on
+// another thread never holds up record().
+class Journal {
+private:
+    FILE* file = nullptr;               // ioLock
+    string path;
+    string pending;                     // lock, from here down
+    int pendingRecords = 0;
+    int groupSize = 1;
+    size_t bytes = 0;                   // committed size of the current journal file
+    string cutRecords;                  // logged before cut(), bound for archiveTarget
+    string archiveTarget;
+    bool cutArchived = true;
+    mutex lock;
+    mutex ioLock;
+
+    // Finish a cut: write the records logged before it to the current file, then
+    // move the file into archivePath and start an empty one. Called with ioLock held.
+    bool moveToArchive(const string& records, const string& archivePath) {
+        if (!file) return false;
+        bool ok = records.empty() || fwrite(records.data(), 1, records.size(), file) == records.size();
+        ok = syncFile(file) && ok;
+        fclose(file);
+        file = nullptr;
+
+        if (ok && !fileExists(archivePath)) {
+            ok = rename(path.c_str(), archivePath.c_str()) == 0;
+        } else if (ok) {
+            MappedFile current;
+            FILE* archive = fopen(archivePath.c_str(), "ab");
+            ok = archive && current.open(path);
+            if (ok && current.size() > 0) {
+                ok = fwrite(current.begin(), 1, current.size(), archive) == current.size();
+            }
+            if (archive) ok = syncFile(archive) && ok;
+            if (archive) fclose(archive);
+            current.close();
+            if (ok) remove(path.c_str());
+        }
+        file = fopen(path.c_str(), ok ? "wb" : "ab");
+        size_t length = 0;
+        if (file) {
+            fseek(file, 0, SEEK_END);
+            length = (size_t)ftell(file);
+        }
+        lock_guard<mutex> guard(lock);
+        bytes = length;
+        cutArchived = ok && file;
+        return cutArchived;
+    }
+
+    // Write out an unfinished cut, then everything queued. Called with ioLock held.
+    bool writeOut() {
+        string archivePath, before, batch;
+        {
+            lock_guard<mutex> guard(lock);
+            archivePath.swap(archiveTarget);
+            before.swap(cutRecords);
+            batch.swap(pending);
+            pendingRecords = 0;
+        }
+        bool ok = archivePath.empty() || moveToArchive(before, archivePath);
+        if (batch.empty()) return ok;
+        bool written = file && fwrite(batch.data(), 1, batch.size(), file) == batch.size();
+        written = written && syncFile(file);
+        if (written) {
+            lock_guard<mutex> guard(lock);
+            bytes += batch.size();
+        }
+        return ok && written;
+    }
+
+    static void appendField(ostringstream& out, bool value) { out << (value ? "1" : "0"); }
+    template <typename T>
+    static void appendField(ostringstream& out, const T& value) { out << value; }
+
+public:
+    Journal() {}
+    ~Journal() { close(); }
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    bool open(const string& filename, int recordsPerCommit = 1) {
+        lock_guard<mutex> io(ioLock);
+        lock_guard<mutex> guard(lock);
+        path = filename;
+        groupSize = max(1, recordsPerCommit);
+        file = fopen(path.c_str(), "ab");
+        if (!file) return false;
+        fseek(file, 0, SEEK_END);
+        bytes = (size_t)ftell(file);
+        return true;
+    }
+
+    void close() {
+        lock_guard<mutex> io(ioLock);
+        if (!file) return;
+        writeOut();
+        fclose(file);
+        file = nullptr;
+    }
+
+    // Records per automatic commit; INT_MAX leaves committing to the caller
+    void setGroupSize(int recordsPerCommit) {
+        lock_guard<mutex> guard(lock);
+        groupSize = max(1, recordsPerCommit);
+    }
+
+    // Queue one record; commits when the group is full
+    template <typename... Fields>
+    void record(char op, const Fields&... fields) {
+        ostringstream out;
+        out << op;
+        int unpack[] = {0, (out << ',', appendField(out, fields), 0)...};
+        (void)unpack;
+        string line = out.str();
+
+        char sum[16];
+        snprintf(sum, sizeof(sum), "#%08x\n", checksum(line));
+
+        bool full;
+        {
+            lock_guard<mutex> guard(lock);
+            pending += line;
+            pending += sum;
+            full = ++pendingRecords >= groupSize;
+        }
+        if (full) commit();
+    }
+
+    // Make every queued record durable
+    bool commit() {
+        lock_guard<mutex> io(ioLock);
+        return writeOut();
+    }
+
+    size_t size() {
+        lock_guard<mutex> guard(lock);
+        return bytes + cutRecords.size() + pending.size();
+    }
+
+    // Records queued but not yet committed
+    int waiting() {
+        lock_guard<mutex> guard(lock);
+        return pendingRecords;
+    }
+
+    // Split the log here without touching the disk: everything logged so far is
+    // moved into archivePath by the next commit(), and later records start an
+    // empty journal. If archivePath is still there from an unfinished compaction,
+    // the records are appended to it instead so nothing that is not yet in a
+    // snapshot gets lost. False if the previous cut has not been committed yet.
+    bool cut(const string& archivePath) {
+        lock_guard<mutex> guard(lock);
+        if (!archiveTarget.empty()) return false;
+        cutRecords.swap(pending);
+        pendingRecords = 0;
+        archiveTarget = archivePath;
+        cutArchived = false;
+        return true;
+    }
+
+    // Whether the last cut made it into the archive (once committed)
+    bool cutCommitted() {
+        lock_guard<mutex> guard(lock);
+        return cutArchived;
+    }
+
+    // Move everything logged so far into archivePath and start an empty journal
+    bool rotate(const string& archivePath) {
+        return cut(archivePath) && commit() && cutCommitted();
+    }
+
+    // Call apply(fields, count) for every intact record in filename, in order.
+    // Replay stops at the first torn or corrupted record, since nothing after a
+    // crash point can be trusted; validBytes receives the length of the intact
+    // prefix. Returns the number of records applied.
+    template <typename Apply>
+    static size_t replay(const string& filename, Apply apply, size_t* validBytes = nullptr) {
+        if (validBytes) *validBytes = 0;
+        MappedFile mapped;
+        if (!mapped.open(filename) || mapped.size() == 0) return 0;
+
+        size_t applied = 0;
+        const char* p = mapped.begin();
+        const char* end = mapped.end();
+        while (p < end) {
+            const char* newline = (const char*)memchr(p, '\n', end - p);
+            if (!newline) break; // torn tail
+            string_view line(p, newline - p);
+            p = newline + 1;
+
+            size_t hashPos = line.rfind('#');
+            if (hashPos == string_view::npos) break;
+            string_view payload = line.substr(0, hashPos);
+            unsigned int expected = (unsigned int)strtoul(string(line.substr(hashPos + 1)).c_str(), nullptr, 16);
+            if (checksum(payload) != expected) break;
+
+            vector<string_view> fields;
+            size_t start = 0;
+            while (true) {
+                size_t comma = payload.find(',', start);
+                fields.push_back(payload.substr(start, comma == string_view::npos ? string_view::npos : comma - start));
+                if (comma == string_view::npos) break;
+                start = comma + 1;
+            }
+            apply(fields.data(), (int)fields.size());
+            applied++;
+            if (validBytes) *validBytes = p - mapped.begin();
+        }
+        return applied;
+    }
+};
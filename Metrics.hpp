@@ -0,0 +1,256 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+// Operation counters and latency histograms. Every instrumented operation opens an
+// APUEC_TIME(op) scope; its duration lands in the calling thread's own histogram
+// for that operation, so instrumented code can run on any number of threads (the
+// registry's shards, say) without them fighting over shared counters.
+// writeMetrics merges every thread's histograms when it runs.
+//
+// Build with -DAPUEC_NO_METRICS to compile all of it out: APUEC_TIME expands to
+// nothing and writeMetrics only says that metrics are off.
+
+enum class Operation {
+    Enqueue, EnqueueBatch, CheckIn, Withdraw, EditInfo, UpdateStatus,
+    LoadCsv, SaveCsv, LoadSnapshot, AddWildcard, RedeemWildcard, JournalCommit, Compact,
+    Count
+};
+
+inline const char* operationName(Operation op) {
+    static const char* names[] = {
+        "enqueue", "enqueueBatch", "checkIn", "withdraw", "editInfo", "updateTournamentStatus",
+        "loadCSV", "saveCSV", "loadSnapshot", "addWildcard", "redeemWildcard", "journalCommit", "compact"
+    };
+    return names[(int)op];
+}
+
+#ifndef APUEC_NO_METRICS
+
+// Log-linear histogram of nanosecond latencies (HDR style): each power of two is
+// split into 8 sub-buckets, so any value is recorded within 12.5% using 512 counters.
+// Only one thread records into a histogram; the counters are atomic so that others
+// can read and merge it at the same time.
+class LatencyHistogram {
+private:
+    static const int SubBits = 3;
+    static const int SubBuckets = 1 << SubBits;
+    static const int Buckets = 64 * SubBuckets;
+
+    atomic<uint64_t> counts[Buckets];
+    atomic<uint64_t> total{0};
+    atomic<uint64_t> sumNs{0};
+    atomic<uint64_t> maxNs{0};
+
+    static int highestBit(uint64_t value) {
+#if defined(_MSC_VER)
+        unsigned long bit;
+        _BitScanReverse64(&bit, value);
+        return (int)bit;
+#else
+        return 63 - __builtin_clzll(value);
+#endif
+    }
+
+    static int bucketOf(uint64_t ns) {
+        if (ns < (uint64_t)SubBuckets) return (int)ns;
+        int msb = highestBit(ns);
+        int sub = (int)((ns >> (msb - SubBits)) & (SubBuckets - 1));
+        return ((msb - SubBits + 1) << SubBits) + sub;
+    }
+
+    // Smallest value that falls in bucket
+    static uint64_t bucketStart(int bucket) {
+        if (bucket < SubBuckets) return (uint64_t)bucket;
+        int msb = (bucket >> SubBits) + SubBits - 1;
+        return (1ULL << msb) | ((uint64_t)(bucket & (SubBuckets - 1)) << (msb - SubBits));
+    }
+
+public:
+    LatencyHistogram() { reset(); }
+
+    // Owning thread only: plain loads and stores, no read-modify-write
+    void record(uint64_t ns) {
+        atomic<uint64_t>& bucket = counts[bucketOf(ns)];
+        bucket.store(bucket.load(memory_order_relaxed) + 1, memory_order_relaxed);
+        total.store(total.load(memory_order_relaxed) + 1, memory_order_relaxed);
+        sumNs.store(sumNs.load(memory_order_relaxed) + ns, memory_order_relaxed);
+        if (ns > maxNs.load(memory_order_relaxed)) maxNs.store(ns, memory_order_relaxed);
+    }
+
+    // Add other's counts to this one; nobody else may be recording into this one
+    void merge(const LatencyHistogram& other) {
+        for (int i = 0; i < Buckets; ++i) {
+            counts[i].store(counts[i].load(memory_order_relaxed) + other.counts[i].load(memory_order_relaxed),
+                            memory_order_relaxed);
+        }
+        total.store(count() + other.count(), memory_order_relaxed);
+        sumNs.store(sumNs.load(memory_order_relaxed) + other.sumNs.load(memory_order_relaxed), memory_order_relaxed);
+        if (other.max() > max()) maxNs.store(other.max(), memory_order_relaxed);
+    }
+
+    void reset() {
+        for (int i = 0; i < Buckets; ++i) counts[i].store(0, memory_order_relaxed);
+        total.store(0, memory_order_relaxed);
+        sumNs.store(0, memory_order_relaxed);
+        maxNs.store(0, memory_order_relaxed);
+    }
+
+    uint64_t count() const { return total.load(memory_order_relaxed); }
+    uint64_t max() const { return maxNs.load(memory_order_relaxed); }
+
+    double mean() const {
+        uint64_t n = count();
+        return n ? (double)sumNs.load(memory_order_relaxed) / n : 0.0;
+    }
+
+    // Upper end of the bucket holding the q-th quantile (0 < q <= 1)
+    uint64_t percentile(double q) const {
+        uint64_t n = count();
+        if (n == 0) return 0;
+        uint64_t target = (uint64_t)(q * n);
+        if (target < q * n || target == 0) target++;   // rank ceil(q * n), at least 1
+        uint64_t seen = 0;
+        for (int i = 0; i < Buckets; ++i) {
+            seen += counts[i].load(memory_order_relaxed);
+            if (seen >= target) {
+                uint64_t end = (i + 1 < Buckets) ? bucketStart(i + 1) - 1 : max();
+                return end < max() ? end : max();
+            }
+        }
+        return max();
+    }
+};
+
+struct OperationHistograms {
+    LatencyHistogram histograms[(int)Operation::Count];
+
+    void merge(const OperationHistograms& other) {
+        for (int i = 0; i < (int)Operation::Count; ++i) histograms[i].merge(other.histograms[i]);
+    }
+
+    void reset() {
+        for (int i = 0; i < (int)Operation::Count; ++i) histograms[i].reset();
+    }
+};
+
+// Every thread's histograms, plus what threads that have exited left behind
+class MetricsRegistry {
+private:
+    mutex lock;
+    vector<OperationHistograms*> live;
+    OperationHistograms retired;
+
+public:
+    void add(OperationHistograms* h) {
+        lock_guard<mutex> guard(lock);
+        live.push_back(h);
+    }
+
+    // Called by the thread itself as it exits, so nothing records into h any more
+    void remove(OperationHistograms* h) {
+        lock_guard<mutex> guard(lock);
+        retired.merge(*h);
+        for (size_t i = 0; i < live.size(); ++i) {
+            if (live[i] != h) continue;
+            live[i] = live.back();
+            live.pop_back();
+            break;
+        }
+    }
+
+    // Add everything recorded so far to out
+    void collect(OperationHistograms& out) {
+        lock_guard<mutex> guard(lock);
+        out.merge(retired);
+        for (OperationHistograms* h : live) out.merge(*h);
+    }
+
+    // Counts recorded by a thread at this very moment may survive the reset
+    void reset() {
+        lock_guard<mutex> guard(lock);
+        retired.reset();
+        for (OperationHistograms* h : live) h->reset();
+    }
+};
+
+inline MetricsRegistry& metricsRegistry() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+// The calling thread's histogram for op, registered on the thread's first use
+inline LatencyHistogram& threadHistogram(Operation op) {
+    struct Registered {
+        unique_ptr<OperationHistograms> histograms{new OperationHistograms};
+        Registered() { metricsRegistry().add(histograms.get()); }
+        ~Registered() { metricsRegistry().remove(histograms.get()); }
+    };
+    thread_local Registered mine;
+    return mine.histograms->histograms[(int)op];
+}
+
+// Records the lifetime of the scope into op's histogram
+class ScopedTimer {
+private:
+    Operation op;
+    chrono::steady_clock::time_point start;
+
+public:
+    explicit ScopedTimer(Operation operation) : op(operation), start(chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        auto elapsed = chrono::steady_clock::now() - start;
+        threadHistogram(op).record((uint64_t)chrono::duration_cast<chrono::nanoseconds>(elapsed).count());
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+#define APUEC_CONCAT_(a, b) a##b
+#define APUEC_CONCAT(a, b) APUEC_CONCAT_(a, b)
+#define APUEC_TIME(op) ScopedTimer APUEC_CONCAT(scopedTimer, __LINE__)(op)
+
+// One line per operation that has run, over all threads: count, mean and
+// percentiles in microseconds
+inline void writeMetrics(ostream& out) {
+    unique_ptr<OperationHistograms> merged(new OperationHistograms);
+    metricsRegistry().collect(*merged);
+    char line[160];
+    snprintf(line, sizeof(line), "%-24s %10s %10s %10s %10s %10s %10s\n",
+             "operation", "count", "mean_us", "p50_us", "p90_us", "p99_us", "max_us");
+    out << line;
+    for (int i = 0; i < (int)Operation::Count; ++i) {
+        const LatencyHistogram& h = merged->histograms[i];
+        if (h.count() == 0) continue;
+        snprintf(line, sizeof(line), "%-24s %10llu %10.2f %10.2f %10.2f %10.2f %10.2f\n",
+                 operationName((Operation)i), (unsigned long long)h.count(), h.mean() / 1000.0,
+                 h.percentile(0.50) / 1000.0, h.percentile(0.90) / 1000.0,
+                 h.percentile(0.99) / 1000.0, h.max() / 1000.0);
+        out << line;
+    }
+}
+
+inline void resetMetrics() { metricsRegistry().reset(); }
+
+#else
+
+#define APUEC_TIME(op) ((void)0)
+
+inline void writeMetrics(ostream& out) { out << "Operation metrics are disabled in this build.\n"; }
+inline void resetMetrics() {}
+
+#endif
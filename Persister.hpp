@@ -0,0 +1,110 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "Journal.hpp"
+
+using namespace std;
+
+// Write-behind for the interactive thread: it only hands work over and never waits
+// on the disk. noteDirty() reports journal records waiting to be committed;
+// writeLater() queues a whole file (the latest contents per file win, so a file
+// replaced ten times between rounds is written once). A background thread commits
+// the journal and writes the queued files every interval, or as soon as dirtyLimit
+// records are waiting, so a crash loses at most that much. Files go through
+// writeFileAtomically (temp file, fsync, rename). Everything still queued is
+// written before the destructor returns.
+class Persister {
+private:
+    Journal* journal;
+    chrono::milliseconds interval;
+    size_t dirtyLimit;
+    mutex lock;
+    condition_variable wake, done;
+    size_t dirty = 0;
+    vector<pair<string, string>> files;
+    uint64_t requested = 0;     // flush() calls so far
+    uint64_t completed = 0;     // flush() calls covered by a finished round
+    uint64_t written = 0;       // files written so far
+    bool stopping = false;
+    thread worker;              // last, so it starts after everything it uses
+
+    void run() {
+        unique_lock<mutex> guard(lock);
+        while (true) {
+            wake.wait_for(guard, interval, [this]() {
+                return stopping || dirty >= dirtyLimit || requested > completed;
+            });
+            bool last = stopping;
+            uint64_t round = requested;
+            vector<pair<string, string>> batch;
+            batch.swap(files);
+            dirty = 0;
+            guard.unlock();
+
+            if (journal) journal->commit();
+            for (auto& file : batch) writeFileAtomically(file.first, file.second);
+
+            guard.lock();
+            written += batch.size();
+            completed = round;
+            done.notify_all();
+            if (last) return;
+        }
+    }
+
+public:
+    Persister(Journal* log, chrono::milliseconds every, size_t dirtyRecords)
+        : journal(log), interval(every), dirtyLimit(max<size_t>(1, dirtyRecords)),
+          worker([this]() { run(); }) {}
+
+    ~Persister() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+
+    Persister(const Persister&) = delete;
+    Persister& operator=(const Persister&) = delete;
+
+    // records journal records are waiting; commits early once there are enough
+    void noteDirty(size_t records) {
+        lock_guard<mutex> guard(lock);
+        dirty = records;
+        if (dirty >= dirtyLimit) wake.notify_one();
+    }
+
+    void writeLater(const string& path, string contents) {
+        lock_guard<mutex> guard(lock);
+        for (auto& file : files) {
+            if (file.first == path) {
+                file.second = move(contents);
+                return;
+            }
+        }
+        files.push_back(make_pair(path, move(contents)));
+    }
+
+    // Files actually written; fewer than writeLater calls when they coalesce
+    uint64_t filesWritten() {
+        lock_guard<mutex> guard(lock);
+        return written;
+    }
+
+    // Wait until everything handed over before this call is on disk
+    void flush() {
+        unique_lock<mutex> guard(lock);
+        uint64_t target = ++requested;
+        wake.notify_one();
+        done.wait(guard, [&]() { return completed >= target; });
+    }
+};
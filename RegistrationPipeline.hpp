@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include "ConcurrentCircularQueue.hpp"
+
+using namespace std;
+
+// Bounded ring for many producers and one consumer. Each push claims a ticket with
+// one fetch_add; the ticket picks the cell, and the cell's sequence number says
+// whether it is free for that ticket (== ticket) or holds its value (== ticket + 1).
+// No locks anywhere: a producer only waits when the ring is full and its cell has
+// not been drained yet. The consumer takes values strictly in ticket order.
+template <typename T>
+class MpscRing {
+private:
+    struct Cell {
+        atomic<uint64_t> sequence;
+        T value;
+    };
+
+    unique_ptr<Cell[]> cells;
+    uint64_t mask;
+    alignas(64) atomic<uint64_t> tail{0};   // next ticket
+    alignas(64) uint64_t head = 0;          // next ticket to drain (consumer only)
+
+public:
+    // capacity is rounded up to a power of two
+    explicit MpscRing(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size *= 2;
+        cells.reset(new Cell[size]);
+        mask = size - 1;
+        for (size_t i = 0; i < size; ++i) cells[i].sequence.store(i, memory_order_relaxed);
+    }
+
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    // Store value and return its ticket (0, 1, 2, ... in push order)
+    uint64_t push(T value) {
+        uint64_t ticket = tail.fetch_add(1, memory_order_relaxed);
+        Cell& cell = cells[ticket & mask];
+        while (cell.sequence.load(memory_order_acquire) != ticket) this_thread::yield();
+        cell.value = move(value);
+        cell.sequence.store(ticket + 1, memory_order_release);
+        return ticket;
+    }
+
+    // Move up to limit ready values into out, in ticket order; returns how many
+    size_t drain(vector<T>& out, size_t limit) {
+        size_t taken = 0;
+        while (taken < limit) {
+            Cell& cell = cells[head & mask];
+            if (cell.sequence.load(memory_order_acquire) != head + 1) break;
+            out.push_back(move(cell.value));
+            cell.sequence.store(head + mask + 1, memory_order_release);
+            head++;
+            taken++;
+        }
+        return taken;
+    }
+
+    // Tickets handed out so far
+    uint64_t claimed() const { return tail.load(memory_order_acquire); }
+};
+
+// Registration front end for sign-up rushes. enqueue() never takes the queue's
+// lock: it reserves the player's ID from the queue's own atomic counter (the one
+// every other registration takes IDs from too), puts the registration with its ID
+// in the ring and returns the ID straight away. One applier thread drains the ring
+// and registers each drained run with a single enqueueBatch, so the writer lock,
+// the merge into the seeding order and the admission update are paid once per
+// batch instead of once per player.
+//
+// Direct registrations may run alongside the pipeline. Only something that puts
+// players back under IDs of its own (a CSV load or journal replay) can take an ID
+// the pipeline has promised; enqueueBatch then rejects that registration and the
+// applier reports it on cerr. A player is only visible in the queue once the
+// applier has reached them (see flush).
+class RegistrationPipeline {
+private:
+    ConcurrentCircularQueue& queue;
+    MpscRing<Registration> ring;
+    size_t batchLimit;
+    atomic<uint64_t> applied{0};    // tickets registered in the queue
+    atomic<uint64_t> dropped{0};    // rejected by the queue (see rejected)
+    atomic<bool> stopping{false};
+    thread applier;                 // last, so it starts after everything it uses
+
+    void run() {
+        vector<Registration> batch;
+        batch.reserve(batchLimit);
+        while (true) {
+            batch.clear();
+            ring.drain(batch, batchLimit);
+            if (batch.empty()) {
+                if (stopping.load(memory_order_acquire) && applied.load() == ring.claimed()) return;
+                this_thread::sleep_for(chrono::microseconds(100));
+                continue;
+            }
+            BatchResult result = queue.enqueueBatch(batch);
+            if (result.rejected > 0) {
+                dropped.fetch_add(result.rejected, memory_order_relaxed);
+                cerr << "RegistrationPipeline: " << result.rejected
+                     << " registration(s) not applied, their IDs were taken by a load or replay\n";
+            }
+            applied.fetch_add(batch.size(), memory_order_release);
+        }
+    }
+
+public:
+    RegistrationPipeline(ConcurrentCircularQueue& q, size_t ringSize = 1 << 16, size_t maxBatch = 4096)
+        : queue(q), ring(ringSize), batchLimit(max<size_t>(1, maxBatch)),
+          applier([this]() { run(); }) {}
+
+    // Registers everything already accepted, then stops
+    ~RegistrationPipeline() {
+        stopping.store(true, memory_order_release);
+        applier.join();
+    }
+
+    RegistrationPipeline(const RegistrationPipeline&) = delete;
+    RegistrationPipeline& operator=(const RegistrationPipeline&) = delete;
+
+    // Safe from any number of threads. Returns the ID the player will have.
+    int enqueue(string username, int rank, string university, bool isWildcard = false) {
+        int id = queue.reserveIDs();
+        ring.push(Registration{move(username), rank, move(university), isWildcard, id});
+        return id;
+    }
+
+    // Wait until every registration accepted before this call is in the queue
+    void flush() {
+        uint64_t target = ring.claimed();
+        while (applied.load(memory_order_acquire) < target) this_thread::sleep_for(chrono::microseconds(50));
+    }
+
+    // Accepted but not yet in the queue
+    uint64_t pending() const { return ring.claimed() - applied.load(memory_order_acquire); }
+
+    // Registrations the queue rejected because their ID was already taken
+    uint64_t rejected() const { return dropped.load(memory_order_relaxed); }
+};
@@ -0,0 +1,579 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Task2.hpp"
+
+using namespace std;
+
+// An immutable copy of one player as of some roster version. Same field names as
+// Player, so the listing and CSV helpers render it unchanged. The strings are held
+// by the version's node, so they stay valid while the version is pinned.
+struct PlayerVersion {
+    int playerID;
+    int rank;
+    const InternedString* username;
+    const InternedString* university;
+    time_t registrationTime;
+    bool checkInStatus;
+    bool isWildcard;
+    bool inTournament;
+};
+
+// Persistent (copy-on-write) versions of a roster, for readers that must not hold
+// up writers: exports, reports, listings on another thread.
+//
+// Each version is a treap in seeding order (Policy's key) whose nodes are never
+// changed once published. A write copies only the O(log n) nodes on the paths it
+// touches and shares the rest with the previous version, then publishes the new
+// root with one atomic store. Readers pin() the current version and walk it with no
+// lock at all, for as long as they like; the writer never waits for them. Each
+// version also carries a treap keyed by player ID (copied the same way), so a
+// point lookup is a pin and two O(log n) walks, with no lock either.
+//
+// Check-ins are the one change that does not make a version: they set a bit in an
+// atomic set shared by every version since the last reload, which readers OR into
+// the flag. The flag only goes from false to true, so that is safe to see early.
+//
+// Memory is reclaimed by epochs, using version numbers as the epoch: a node
+// replaced while publishing version v is only reachable from versions before v,
+// so it is freed once every pinned reader is on v or later. Readers announce
+// their version in one of MaxReaders slots.
+template <typename Policy>
+class RosterVersions {
+private:
+    typedef typename Policy::Key Key;
+
+    struct Node {
+        PlayerVersion record;
+        Key key;
+        uint64_t priority;
+        uint64_t born;          // version that created the node
+        size_t size;            // nodes in this subtree
+        const Node* left;
+        const Node* right;
+        StringRef username;     // hold the record's strings
+        StringRef university;
+    };
+
+    // The same treap by player ID, mapping each player to their key in the roster
+    struct IdNode {
+        int key;
+        Key seed;
+        uint64_t priority;
+        uint64_t born;
+        size_t size;
+        const IdNode* left;
+        const IdNode* right;
+    };
+
+    struct State {
+        const Node* root;
+        const IdNode* ids;
+        uint64_t version;
+        size_t admitted;        // records holding a tournament slot (a prefix of the order)
+        uint64_t loaded;        // version of the last reload
+        AtomicBitSet* checkIns; // checked in since that reload
+    };
+
+    static const int MaxReaders = 64;
+    static const uint64_t Idle = UINT64_MAX;
+
+    struct alignas(64) ReaderSlot {
+        atomic<uint64_t> pinned{Idle};
+    };
+
+    atomic<const State*> current;
+    mutable ReaderSlot readers[MaxReaders];
+
+    // Writer state, guarded by writeLock
+    mutex writeLock;
+    uint64_t writing = 0;                               // version being built
+    vector<pair<uint64_t, const Node*>> retiredNodes;   // (version that dropped it, node)
+    vector<pair<uint64_t, const IdNode*>> retiredIds;
+    vector<pair<uint64_t, const State*>> retiredStates;
+    vector<pair<uint64_t, AtomicBitSet*>> retiredCheckIns;
+
+    template <typename N>
+    static size_t sizeOf(const N* n) { return n ? n->size : 0; }
+
+    static uint64_t priorityOf(int playerID) {
+        // splitmix64: a fixed pseudo-random priority per player keeps the treap balanced
+        uint64_t z = (uint64_t)(uint32_t)playerID + 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    template <typename N>
+    static void resize(N* n) { n->size = 1 + sizeOf(n->left) + sizeOf(n->right); }
+
+    Node* create(const PlayerVersion& record) {
+        return new Node{record, Policy::keyOf(&record), priorityOf(record.playerID), writing, 1, nullptr, nullptr,
+                        StringRef::share(record.username), StringRef::share(record.university)};
+    }
+
+    IdNode* createId(int id, const Key& seed) {
+        return new IdNode{id, seed, priorityOf(id), writing, 1, nullptr, nullptr};
+    }
+
+    void retire(const Node* n) { retiredNodes.push_back(make_pair(writing, n)); }
+    void retire(const IdNode* n) { retiredIds.push_back(make_pair(writing, n)); }
+
+    // A writable copy of n for the version being built. Nodes created by this write
+    // are not visible to anyone yet and are changed in place.
+    template <typename N>
+    N* own(const N* n) {
+        if (n->born == writing) return const_cast<N*>(n);
+        N* copy = new N(*n);
+        copy->born = writing;
+        retire(n);
+        return copy;
+    }
+
+    // A node taken out of the version being built
+    template <typename N>
+    void drop(const N* n) {
+        if (n->born == writing) {
+            delete n;
+        } else {
+            retire(n);
+        }
+    }
+
+    // The treap operations below work on either tree
+
+    // l gets the keys below key, r the rest
+    template <typename N, typename K>
+    void split(const N* t, const K& key, const N*& l, const N*& r) {
+        if (!t) {
+            l = r = nullptr;
+            return;
+        }
+        N* n = own(t);
+        if (t->key < key) {
+            split(t->right, key, n->right, r);
+            l = n;
+        } else {
+            split(t->left, key, l, n->left);
+            r = n;
+        }
+        resize(n);
+    }
+
+    // Every key in a is below every key in b
+    template <typename N>
+    const N* merge(const N* a, const N* b) {
+        if (!a) return b;
+        if (!b) return a;
+        if (a->priority > b->priority) {
+            N* n = own(a);
+            n->right = merge(a->right, b);
+            resize(n);
+            return n;
+        }
+        N* n = own(b);
+        n->left = merge(a, b->left);
+        resize(n);
+        return n;
+    }
+
+    template <typename N>
+    const N* insert(const N* t, N* node) {
+        if (!t || node->priority > t->priority) {
+            split(t, node->key, node->left, node->right);
+            resize(node);
+            return node;
+        }
+        N* n = own(t);
+        if (node->key < t->key) {
+            n->left = insert(t->left, node);
+        } else {
+            n->right = insert(t->right, node);
+        }
+        resize(n);
+        return n;
+    }
+
+    // Unlink the node with key; the caller drop()s it once done with it
+    template <typename N, typename K>
+    const N* erase(const N* t, const K& key, const N*& removed) {
+        if (!t) return nullptr;
+        if (key < t->key || t->key < key) {
+            N* n = own(t);
+            if (key < t->key) {
+                n->left = erase(t->left, key, removed);
+            } else {
+                n->right = erase(t->right, key, removed);
+            }
+            resize(n);
+            return n;
+        }
+        removed = t;
+        return merge(t->left, t->right);
+    }
+
+    // Copy the path to the node with key and let change() edit it in place
+    template <typename N, typename K, typename Change>
+    const N* update(const N* t, const K& key, Change change) {
+        N* n = own(t);
+        if (key < t->key) {
+            n->left = update(t->left, key, change);
+        } else if (t->key < key) {
+            n->right = update(t->right, key, change);
+        } else {
+            change(n);
+        }
+        return n;
+    }
+
+    template <typename N, typename K>
+    static const N* lookup(const N* t, const K& key) {
+        while (t && (key < t->key || t->key < key)) t = (key < t->key) ? t->left : t->right;
+        return t;
+    }
+
+    template <typename P>
+    static PlayerVersion recordOf(const P* p) {
+        return PlayerVersion{p->playerID, p->rank, p->username, p->university, p->registrationTime,
+                             (bool)p->checkInStatus, p->isWildcard, p->inTournament};
+    }
+
+    // Bring the working trees up to date for one player (p is null if they are gone)
+    template <typename P>
+    void apply(const Node*& root, const IdNode*& ids, size_t& admitted, int id, const P* p) {
+        const IdNode* old = lookup(ids, id);
+        const Node* removed = nullptr;
+        if (p) {
+            PlayerVersion record = recordOf(p);
+            Key key = Policy::keyOf(&record);
+            if (old && !(old->seed < key) && !(key < old->seed)) {
+                root = update(root, key, [&](Node* n) {
+                    admitted -= n->record.inTournament;
+                    n->record = record;
+                    n->username = StringRef::share(record.username);
+                    n->university = StringRef::share(record.university);
+                });
+            } else {
+                if (old) {
+                    root = erase(root, old->seed, removed);
+                    admitted -= removed->record.inTournament;
+                    drop(removed);
+                    ids = update(ids, id, [&](IdNode* n) { n->seed = key; });
+                } else {
+                    ids = insert(ids, createId(id, key));
+                }
+                root = insert(root, create(record));
+            }
+            admitted += record.inTournament;
+        } else if (old) {
+            root = erase(root, old->seed, removed);
+            admitted -= removed->record.inTournament;
+            drop(removed);
+            const IdNode* gone = nullptr;
+            ids = erase(ids, id, gone);
+            drop(gone);
+        }
+    }
+
+    template <typename N>
+    void retireTree(const N* n) {
+        if (!n) return;
+        retireTree(n->left);
+        retireTree(n->right);
+        retire(n);
+    }
+
+    // Make the working trees the current version, then free what no reader can see
+    void publish(const Node* root, const IdNode* ids, size_t admitted, uint64_t loaded, AtomicBitSet* checkIns) {
+        const State* old = current.load();
+        current.store(new State{root, ids, writing, admitted, loaded, checkIns});
+        retiredStates.push_back(make_pair(writing, old));
+        reclaim();
+    }
+
+    // Free every retired entry no pinned reader can still reach
+    template <typename T>
+    static void reclaim(vector<pair<uint64_t, T>>& retired, uint64_t oldest) {
+        size_t kept = 0;
+        for (size_t i = 0; i < retired.size(); ++i) {
+            if (retired[i].first <= oldest) {
+                delete retired[i].second;
+            } else {
+                retired[kept++] = retired[i];
+            }
+        }
+        retired.resize(kept);
+    }
+
+    void reclaim() {
+        uint64_t oldest = Idle;
+        for (int i = 0; i < MaxReaders; ++i) oldest = min(oldest, readers[i].pinned.load());
+        reclaim(retiredNodes, oldest);
+        reclaim(retiredIds, oldest);
+        reclaim(retiredStates, oldest);
+        reclaim(retiredCheckIns, oldest);
+    }
+
+    // Treap over nodes already in key order, built in O(n) with no path copying: a
+    // stack holds the right spine of the Cartesian tree
+    template <typename N>
+    static const N* fromSorted(const vector<N*>& nodes) {
+        vector<N*> spine;
+        for (N* n : nodes) {
+            N* lastPopped = nullptr;
+            while (!spine.empty() && spine.back()->priority < n->priority) {
+                lastPopped = spine.back();
+                spine.pop_back();
+            }
+            n->left = lastPopped;
+            if (!spine.empty()) spine.back()->right = n;
+            spine.push_back(n);
+        }
+        if (spine.empty()) return nullptr;
+        fixSizes(spine.front());
+        return spine.front();
+    }
+
+    template <typename N>
+    static size_t fixSizes(N* n) {
+        if (!n) return 0;
+        n->size = 1 + fixSizes(const_cast<N*>(n->left)) + fixSizes(const_cast<N*>(n->right));
+        return n->size;
+    }
+
+    template <typename N>
+    static void destroy(const N* n) {
+        if (!n) return;
+        destroy(n->left);
+        destroy(n->right);
+        delete n;
+    }
+
+public:
+    // A pinned version: stays readable, unchanged, until the View goes away. The
+    // one exception is the check-in flag, which is read live (see checkIn), so a
+    // player checked in after the pin shows as checked in.
+    class View {
+    private:
+        const State* state = nullptr;
+        ReaderSlot* slot = nullptr;
+
+        template <typename Visitor>
+        static bool walk(const Node* n, size_t& skip, size_t& remaining, Visitor& visit) {
+            while (n && remaining > 0) {
+                size_t leftSize = sizeOf(n->left);
+                if (skip < leftSize) {
+                    if (!walk(n->left, skip, remaining, visit)) return false;
+                } else {
+                    skip -= leftSize;
+                }
+                if (remaining == 0) return true;
+                if (skip > 0) {
+                    skip--;
+                } else {
+                    remaining--;
+                    if (!visit(n->record)) return false;
+                }
+                n = n->right;   // loop instead of recursing down the right spine
+            }
+            return true;
+        }
+
+        friend class RosterVersions;
+        View(const State* s, ReaderSlot* r) : state(s), slot(r) {}
+
+        void withCheckIn(PlayerVersion& record) const {
+            if (!record.checkInStatus && state->checkIns->contains(record.playerID)) record.checkInStatus = true;
+        }
+
+    public:
+        View() {}
+        View(View&& other) : state(other.state), slot(other.slot) {
+            other.state = nullptr;
+            other.slot = nullptr;
+        }
+        View& operator=(View&& other) {
+            if (this != &other) {
+                release();
+                state = other.state;
+                slot = other.slot;
+                other.state = nullptr;
+                other.slot = nullptr;
+            }
+            return *this;
+        }
+        ~View() { release(); }
+
+        View(const View&) = delete;
+        View& operator=(const View&) = delete;
+
+        void release() {
+            if (slot) slot->pinned.store(Idle);
+            slot = nullptr;
+            state = nullptr;
+        }
+
+        uint64_t version() const { return state ? state->version : 0; }
+        uint64_t loaded() const { return state ? state->loaded : 0; }
+        size_t size() const { return state ? sizeOf(state->root) : 0; }
+
+        // Copy out the record of player id; false if they are not in this version
+        bool find(int id, PlayerVersion& record) const {
+            if (!state) return false;
+            const IdNode* entry = lookup(state->ids, id);
+            const Node* n = entry ? lookup(state->root, entry->seed) : nullptr;
+            if (!n) return false;
+            record = n->record;
+            withCheckIn(record);
+            return true;
+        }
+
+        // Mark player id as checked in, here and in every other version since the
+        // same reload, at once: one atomic OR, no lock and no new version
+        void checkIn(int id) const {
+            if (state) state->checkIns->insert(id);
+        }
+
+        size_t countOf(PlayerView view) const {
+            if (!state) return 0;
+            if (view == PlayerView::Tournament) return state->admitted;
+            if (view == PlayerView::Waitlist) return size() - state->admitted;
+            return size();
+        }
+
+        // visit(const PlayerVersion&) for at most limit records of view in seeding
+        // order, starting offset places in; stops early if visit returns false.
+        // Reaching the first record is O(log n).
+        template <typename Visitor>
+        void forEach(PlayerView view, size_t offset, size_t limit, Visitor visit) const {
+            if (!state) return;
+            size_t first = (view == PlayerView::Waitlist) ? state->admitted : 0;
+            size_t available = countOf(view);
+            if (offset >= available) return;
+            size_t skip = first + offset;
+            size_t remaining = min(limit, available - offset);
+            auto visitLive = [&](const PlayerVersion& record) {
+                if (record.checkInStatus || !state->checkIns->contains(record.playerID)) return visit(record);
+                PlayerVersion copy = record;
+                copy.checkInStatus = true;
+                return visit(copy);
+            };
+            walk(state->root, skip, remaining, visitLive);
+        }
+
+        template <typename Visitor>
+        void forEach(Visitor visit) const { forEach(PlayerView::All, 0, (size_t)-1, visit); }
+
+        void writeCSV(ostream& file) const {
+            forEach([&](const PlayerVersion& p) {
+                writePlayerCsvRow(file, &p);
+                return true;
+            });
+        }
+
+        void display(ostream& out, PlayerView view, size_t offset, size_t limit,
+                     OutputFormat format = OutputFormat::Table) const {
+            TableRenderer table(out, format, playerColumns, 8, playerTable);
+            table.header();
+            forEach(view, offset, limit, [&](const PlayerVersion& p) {
+                renderPlayerRow(table, &p);
+                return true;
+            });
+            table.footer();
+        }
+    };
+
+
+    RosterVersions() : current(new State{nullptr, nullptr, 0, 0, 0, new AtomicBitSet}) {}
+
+    // No View may outlive the versions it came from
+    ~RosterVersions() {
+        for (auto& retired : retiredNodes) delete retired.second;
+        for (auto& retired : retiredIds) delete retired.second;
+        for (auto& retired : retiredStates) delete retired.second;
+        for (auto& retired : retiredCheckIns) delete retired.second;
+        const State* last = current.load();
+        destroy(last->root);
+        destroy(last->ids);
+        delete last->checkIns;
+        delete last;
+    }
+
+    RosterVersions(const RosterVersions&) = delete;
+    RosterVersions& operator=(const RosterVersions&) = delete;
+
+    // Pin the current version. Lock-free; only waits if MaxReaders views are open.
+    View pin() const {
+        while (true) {
+            for (int i = 0; i < MaxReaders; ++i) {
+                uint64_t expected = Idle;
+                // Claiming with 0 holds off all reclamation until the real version is set
+                if (!readers[i].pinned.compare_exchange_strong(expected, 0)) continue;
+                const State* s = current.load();
+                readers[i].pinned.store(s->version);
+                return View(s, &readers[i]);
+            }
+            this_thread::yield();
+        }
+    }
+
+    uint64_t version() const { return current.load()->version; }
+
+    // Copy out the current record of player id; false if they are not on the roster.
+    // Lock-free, like any other read of a pinned version. Nothing holds the strings
+    // afterwards; pin() and find there to read them.
+    bool find(int id, PlayerVersion& record) const { return pin().find(id, record); }
+
+    // Version of the last rebuild that reloaded the roster
+    uint64_t loaded() const { return current.load()->loaded; }
+
+    // Publish a version with the given players brought up to date. find(id) returns
+    // the live player, or null for players that are gone.
+    template <typename Find>
+    void refresh(const vector<int>& ids, Find find) {
+        if (ids.empty()) return;
+        lock_guard<mutex> guard(writeLock);
+        const State* base = current.load();
+        writing = base->version + 1;
+        const Node* root = base->root;
+        const IdNode* byId = base->ids;
+        size_t admitted = base->admitted;
+        for (int id : ids) apply(root, byId, admitted, id, find(id));
+        publish(root, byId, admitted, base->loaded, base->checkIns);
+    }
+
+    // Publish a version holding exactly the players visited by forEachPlayer
+    // (in seeding order), built in O(n) with no path copying; for loads and other
+    // bulk changes. A reload may bring back the same IDs as different players, so
+    // it starts a new check-in set; every check-in must be in the players by then.
+    template <typename ForEachPlayer>
+    void rebuild(ForEachPlayer forEachPlayer, bool reload = false) {
+        lock_guard<mutex> guard(writeLock);
+        const State* base = current.load();
+        writing = base->version + 1;
+        retireTree(base->root);
+        retireTree(base->ids);
+        uint64_t loaded = base->loaded;
+        AtomicBitSet* checkIns = base->checkIns;
+        if (reload) {
+            retiredCheckIns.push_back(make_pair(writing, checkIns));
+            loaded = writing;
+            checkIns = new AtomicBitSet;
+        }
+
+        vector<Node*> nodes;
+        vector<IdNode*> byId;
+        size_t admitted = 0;
+        forEachPlayer([&](const Player* p) {
+            nodes.push_back(create(recordOf(p)));
+            byId.push_back(createId(p->playerID, nodes.back()->key));
+            admitted += p->inTournament;
+        });
+        sort(byId.begin(), byId.end(), [](const IdNode* a, const IdNode* b) { return a->key < b->key; });
+        publish(fromSorted(nodes), fromSorted(byId), admitted, loaded, checkIns);
+    }
+};
@@ -0,0 +1,308 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Task2.hpp"
+
+using namespace std;
+
+// Headless driver: runs a stream of commands against the queues without prompts.
+// One command per line, fields separated by commas like the CSV files:
+//
+//     register,username,rank,university
+//     import,file                          (batch-register file's username,rank,university[,wildcard] rows)
+//     wildcard-register,code
+//     checkin,id
+//     withdraw,id
+//     edit,id,username,rank,university     (blank fields keep the current value)
+//     addwc,code,username,rank,university
+//     show,<id>
+//     show[,view[,first[,count[,format]]]]
+//
+//     count,term,...                       (number of players matching every term)
+//     list,term,...[,format]               (those players, in seeding order)
+//     find,username[,format]               (players with exactly that username)
+//     search,prefix[,limit[,format]]       (players whose username starts with prefix)
+//     top,k[,format]                       (the k best-ranked players)
+//     ranks,low,high                       (number of players ranked low..high)
+//     standing,id                          (leaderboard position and percentile)
+//     stats                                (roster counts and operation latencies)
+//
+// A show view is all (default), tournament, waitlist or wildcards; first and count
+// pick a window of rows (page N of size k is N*k,k) and format is table (default),
+// tsv or json, so listings can be piped into other tools. Filter terms are all,
+// checkedin, wildcard, tournament, waitlist or uni:<name>, and a leading '!'
+// negates one, e.g. count,tournament,uni:APU,!checkedin
+//
+// Blank lines and lines starting with '#' are skipped. Everything the queues print
+// is collected in a buffer and written out in large pieces.
+
+struct ScriptStats {
+    size_t commands = 0;
+    size_t failed = 0;      // unknown commands, bad arguments, missing IDs or codes
+    double seconds = 0;
+
+    double opsPerSecond() const { return seconds > 0 ? commands / seconds : 0.0; }
+};
+
+class ScriptRunner {
+private:
+    CircularQueue& queue;
+    WildcardQueue& wildcards;
+    ostringstream buffer;
+    static const size_t FlushBytes = 1 << 16;
+
+    // One script line, viewing the script text
+    struct Command {
+        string_view fields[8];
+        int count;
+    };
+
+    static bool parseCommand(const string_view* fields, int count, Command& command) {
+        if (fields[0].empty() || fields[0][0] == '#') return false;
+        command.count = min(count, 8);
+        for (int i = 0; i < command.count; ++i) command.fields[i] = fields[i];
+        return true;
+    }
+
+    void flush(ostream& out) {
+        string text = buffer.str();
+        out.write(text.data(), text.size());
+        buffer.str("");
+    }
+
+    // AND together the filter terms in fields [1, count); a trailing output format
+    // is taken as the format instead
+    bool buildFilter(const Command& c, Bitmap& result, OutputFormat& format) {
+        result = queue.allPlayers();
+        for (int i = 1; i < c.count; ++i) {
+            string_view term = c.fields[i];
+            if (i == c.count - 1 && parseOutputFormat(term, format)) break;
+            bool negate = !term.empty() && term[0] == '!';
+            if (negate) term.remove_prefix(1);
+
+            Bitmap set;
+            if (term == "all") set = queue.allPlayers();
+            else if (term == "checkedin") set = queue.checkedInPlayers();
+            else if (term == "wildcard") set = queue.wildcardPlayers();
+            else if (term == "tournament") set = queue.tournamentPlayers();
+            else if (term == "waitlist") set = queue.waitlistPlayers();
+            else if (term.substr(0, 4) == "uni:") set = queue.universityPlayers(term.substr(4));
+            else return false;
+
+            if (negate) {
+                result -= set;
+            } else {
+                result &= set;
+            }
+        }
+        return true;
+    }
+
+    bool execute(const Command& c) {
+        const string_view* f = c.fields;
+        string_view name = f[0];
+        int id, rank;
+
+        if (name == "register") {
+            if (c.count < 4 || !parseInt(f[2], rank)) return false;
+            queue.enqueue(string(f[1]), rank, string(f[3]));
+            return true;
+        }
+        if (name == "import") {
+            if (c.count < 2) return false;
+            BatchResult result = queue.enqueueBatchFromCSV(string(f[1]));
+            if (result.count == 0) {
+                buffer << "No players imported from " << f[1] << ".\n";
+                return false;
+            }
+            buffer << "Imported " << result.count << " players (" << result.admitted << " in the tournament).\n";
+            return true;
+        }
+        if (name == "wildcard-register") {
+            if (c.count < 2) return false;
+            string username, university;
+            if (!wildcards.redeemWildcard(string(f[1]), username, rank, university)) {
+                buffer << "Invalid or already used coupon code.\n";
+                return false;
+            }
+            queue.enqueue(username, rank, university, true);
+            buffer << "Registered via wildcard.\n";
+            return true;
+        }
+        if (name == "checkin" || name == "withdraw") {
+            if (c.count < 2 || !parseInt(f[1], id) || !queue.exists(id)) {
+                buffer << "Player ID not found.\n";
+                return false;
+            }
+            if (name == "checkin") {
+                queue.checkIn(id);
+            } else {
+                queue.withdraw(id);
+            }
+            return true;
+        }
+        if (name == "edit") {
+            if (c.count < 2 || !parseInt(f[1], id)) return false;
+            const Player* p = queue.find(id);
+            if (!p) {
+                buffer << "Player ID not found.\n";
+                return false;
+            }
+            string username = p->username->text, university = p->university->text;
+            rank = p->rank;
+            if (c.count > 2 && !f[2].empty()) username = string(f[2]);
+            if (c.count > 3 && !f[3].empty() && !parseInt(f[3], rank)) return false;
+            if (c.count > 4 && !f[4].empty()) university = string(f[4]);
+            queue.updateInfo(id, username, rank, university);
+            buffer << "Info updated successfully.\n";
+            return true;
+        }
+        if (name == "addwc") {
+            if (c.count < 5 || !parseInt(f[3], rank)) return false;
+            return wildcards.addWildcard(string(f[1]), string(f[2]), rank, string(f[4]));
+        }
+        if (name == "count" || name == "list") {
+            Bitmap matches;
+            OutputFormat format = OutputFormat::Table;
+            if (!buildFilter(c, matches, format)) return false;
+            if (name == "count") {
+                buffer << matches.count() << "\n";
+            } else {
+                queue.display(matches, format);
+            }
+            return true;
+        }
+        if (name == "stats") {
+            writeStats(buffer, queue, wildcards);
+            return true;
+        }
+        if (name == "find") {
+            OutputFormat format = OutputFormat::Table;
+            if (c.count < 2) return false;
+            if (c.count > 2 && !f[2].empty() && !parseOutputFormat(f[2], format)) return false;
+            vector<const Player*> found = queue.findByUsername(f[1]);
+            if (found.empty()) {
+                buffer << "No player named " << f[1] << ".\n";
+                return false;
+            }
+            queue.display(found, format);
+            return true;
+        }
+        if (name == "search") {
+            int limit = 50;
+            OutputFormat format = OutputFormat::Table;
+            if (c.count < 2) return false;
+            if (c.count > 2 && !f[2].empty() && (!parseInt(f[2], limit) || limit < 0)) return false;
+            if (c.count > 3 && !f[3].empty() && !parseOutputFormat(f[3], format)) return false;
+            queue.display(queue.searchUsername(f[1], (size_t)limit), format);
+            return true;
+        }
+        if (name == "top") {
+            int k;
+            OutputFormat format = OutputFormat::Table;
+            if (c.count < 2 || !parseInt(f[1], k) || k < 0) return false;
+            if (c.count > 2 && !f[2].empty() && !parseOutputFormat(f[2], format)) return false;
+            queue.display(queue.topByRank((size_t)k), format);
+            return true;
+        }
+        if (name == "ranks") {
+            int low, high;
+            if (c.count < 3 || !parseInt(f[1], low) || !parseInt(f[2], high)) return false;
+            buffer << queue.countRankBetween(low, high) << "\n";
+            return true;
+        }
+        if (name == "standing") {
+            double percentile;
+            if (c.count < 2 || !parseInt(f[1], id) || !queue.rankPercentile(id, percentile)) {
+                buffer << "Player ID not found.\n";
+                return false;
+            }
+            char line[96];
+            snprintf(line, sizeof(line), "Player ID %d: #%zu of %zu by rank (percentile %.1f)\n", id,
+                     queue.leaderboardPosition(id), queue.countOf(PlayerView::All), percentile);
+            buffer << line;
+            return true;
+        }
+        if (name == "show") {
+            string_view view = (c.count > 1 && !f[1].empty()) ? f[1] : string_view("all");
+            if (parseInt(view, id)) {
+                queue.displayPlayer(id);
+                return true;
+            }
+            int first = 0, rows = -1;
+            OutputFormat format = OutputFormat::Table;
+            if (c.count > 2 && !f[2].empty() && (!parseInt(f[2], first) || first < 0)) return false;
+            if (c.count > 3 && !f[3].empty() && (!parseInt(f[3], rows) || rows < 0)) return false;
+            if (c.count > 4 && !f[4].empty() && !parseOutputFormat(f[4], format)) return false;
+            size_t limit = rows < 0 ? (size_t)-1 : (size_t)rows;
+
+            if (c.count <= 2 && view == "wildcards") {
+                wildcards.displayWildcards();
+            } else if (c.count <= 2 && view == "all") {
+                queue.display();
+            } else if (view == "wildcards") {
+                wildcards.displayWildcards(first, limit, format);
+            } else if (view == "all") {
+                queue.display(PlayerView::All, first, limit, format);
+            } else if (view == "tournament") {
+                queue.display(PlayerView::Tournament, first, limit, format);
+            } else if (view == "waitlist") {
+                queue.display(PlayerView::Waitlist, first, limit, format);
+            } else {
+                return false;
+            }
+            return true;
+        }
+        return false;
+    }
+
+public:
+    ScriptRunner(CircularQueue& q, WildcardQueue& w) : queue(q), wildcards(w) {}
+
+    // Run every command in [begin, end) and write what they print to out; failed
+    // commands are reported on stderr
+    ScriptStats run(const char* begin, const char* end, ostream& out) {
+        vector<Command> commands;
+        parseCsvRange(begin, end, parseCommand, commands);
+
+        queue.setOutput(buffer);
+        wildcards.setOutput(buffer);
+        ScriptStats stats;
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < commands.size(); ++i) {
+            if (!execute(commands[i])) {
+                stats.failed++;
+                cerr << "Command " << i + 1 << " (" << commands[i].fields[0] << ") failed.\n";
+            }
+            if ((size_t)buffer.tellp() >= FlushBytes) flush(out);
+        }
+        flush(out);
+        out.flush();
+        stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        stats.commands = commands.size();
+        queue.setOutput(cout);
+        wildcards.setOutput(cout);
+        return stats;
+    }
+
+    // Run a script file, or standard input when filename is "-"
+    ScriptStats runFile(const string& filename, ostream& out) {
+        if (filename == "-") {
+            string text((istreambuf_iterator<char>(cin)), istreambuf_iterator<char>());
+            return run(text.data(), text.data() + text.size(), out);
+        }
+        MappedFile file;
+        if (!file.open(filename)) {
+            cerr << "Cannot open script " << filename << "\n";
+            ScriptStats stats;
+            stats.failed = 1;
+            return stats;
+        }
+        return run(file.begin(), file.end(), out);
+    }
+};
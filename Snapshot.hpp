@@ -0,0 +1,228 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "CsvReader.hpp"
+
+using namespace std;
+
+// Binary snapshot of the whole tournament (tournament.snap). Layout:
+//
+//     SnapshotHeader
+//     PlayerRecord[playerCount]       players in tournament order (ring order)
+//     WildcardRecord[wildcardCount]   wildcards in list order
+//     string table                    [uint32 length][bytes] per distinct string
+//
+// String fields are byte offsets into the string table, so each distinct username
+// or university is stored once. A snapshot remembers the size and a content hash of
+// the CSV files it was written with and is only trusted while they still match, so
+// any edit to a CSV (even one that keeps its size and timestamp) retires it; CSV
+// stays the interchange format and the snapshot is just the fast path.
+
+const uint32_t SnapshotVersion = 2;
+
+struct SnapshotHeader {
+    char magic[4];              // "APUS"
+    uint32_t version;
+    uint64_t checksum;          // of the whole file with this field zeroed
+    uint64_t playerCsvSize;
+    uint64_t playerCsvHash;
+    uint64_t wildcardCsvSize;
+    uint64_t wildcardCsvHash;
+    uint32_t playerCount;
+    uint32_t wildcardCount;
+    uint32_t stringBytes;
+    int32_t nextID;
+};
+
+struct PlayerRecord {
+    int32_t playerID;
+    int32_t rank;
+    uint32_t username;
+    uint32_t university;
+    int64_t registered;
+    uint8_t checkedIn;
+    uint8_t isWildcard;
+    uint8_t inTournament;
+    uint8_t reserved[5];
+};
+
+struct WildcardRecord {
+    uint32_t code;
+    uint32_t username;
+    uint32_t university;
+    int32_t rank;
+    uint8_t used;
+    uint8_t reserved[3];
+};
+
+static_assert(sizeof(SnapshotHeader) == 64, "snapshot header must stay fixed-width");
+static_assert(sizeof(PlayerRecord) == 32, "player record must stay fixed-width");
+static_assert(sizeof(WildcardRecord) == 20, "wildcard record must stay fixed-width");
+
+// 64-bit FNV-style hash taken a word at a time, so verifying a large snapshot
+// stays well under the cost of reading it. Hashing can be continued from a
+// previous result as long as that piece was a multiple of 8 bytes long.
+inline uint64_t snapshotChecksum(const char* data, size_t length, uint64_t h = 14695981039346656037ULL) {
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        h = (h ^ word) * 1099511628211ULL;
+        h ^= h >> 29;
+    }
+    for (; i < length; ++i) h = (h ^ (unsigned char)data[i]) * 1099511628211ULL;
+    return h;
+}
+
+// Size and content hash of a file; false if it cannot be read. Hashing runs at
+// memory speed, a small fraction of parsing the same CSV.
+inline bool fileSignature(const string& filename, uint64_t& size, uint64_t& hash) {
+    MappedFile file;
+    if (!file.open(filename)) return false;
+    size = (uint64_t)file.size();
+    hash = snapshotChecksum(file.begin(), file.size());
+    return true;
+}
+
+class SnapshotWriter {
+private:
+    vector<PlayerRecord> players;
+    vector<WildcardRecord> wildcards;
+    string strings;
+    unordered_map<string, uint32_t> offsets;
+
+public:
+    uint32_t intern(const string& text) {
+        auto found = offsets.find(text);
+        if (found != offsets.end()) return found->second;
+        uint32_t offset = (uint32_t)strings.size();
+        uint32_t length = (uint32_t)text.size();
+        strings.append((const char*)&length, sizeof(length));
+        strings.append(text);
+        offsets.emplace(text, offset);
+        return offset;
+    }
+
+    void addPlayer(const PlayerRecord& record) { players.push_back(record); }
+    void addWildcard(const WildcardRecord& record) { wildcards.push_back(record); }
+
+    // Serialize everything; the CSV signatures and checksum are filled in by seal()
+    string finish(int nextID) const {
+        SnapshotHeader header = {};
+        memcpy(header.magic, "APUS", 4);
+        header.version = SnapshotVersion;
+        header.playerCount = (uint32_t)players.size();
+        header.wildcardCount = (uint32_t)wildcards.size();
+        header.stringBytes = (uint32_t)strings.size();
+        header.nextID = nextID;
+
+        string bytes;
+        bytes.reserve(sizeof(header) + players.size() * sizeof(PlayerRecord) +
+                      wildcards.size() * sizeof(WildcardRecord) + strings.size());
+        bytes.append((const char*)&header, sizeof(header));
+        bytes.append((const char*)players.data(), players.size() * sizeof(PlayerRecord));
+        bytes.append((const char*)wildcards.data(), wildcards.size() * sizeof(WildcardRecord));
+        bytes.append(strings);
+        return bytes;
+    }
+
+    // Tie a finished snapshot to the CSV files it mirrors and stamp its checksum
+    static bool seal(string& bytes, const string& playerCsv, const string& wildcardCsv) {
+        SnapshotHeader header;
+        memcpy(&header, bytes.data(), sizeof(header));
+        if (!fileSignature(playerCsv, header.playerCsvSize, header.playerCsvHash) ||
+            !fileSignature(wildcardCsv, header.wildcardCsvSize, header.wildcardCsvHash)) {
+            return false;
+        }
+        header.checksum = 0;
+        memcpy(&bytes[0], &header, sizeof(header));
+        header.checksum = snapshotChecksum(bytes.data(), bytes.size());
+        memcpy(&bytes[0], &header, sizeof(header));
+        return true;
+    }
+};
+
+// Memory-mapped, validated snapshot. Records are read in place.
+class SnapshotView {
+private:
+    MappedFile file;
+    SnapshotHeader header = {};
+    const PlayerRecord* playerRecords = nullptr;
+    const WildcardRecord* wildcardRecords = nullptr;
+    const char* strings = nullptr;
+
+    // A whole string (length and bytes) starts at offset inside the string table
+    bool inStrings(uint32_t offset) const {
+        if ((uint64_t)offset + sizeof(uint32_t) > header.stringBytes) return false;
+        uint32_t length;
+        memcpy(&length, strings + offset, sizeof(length));
+        return (uint64_t)offset + sizeof(uint32_t) + length <= header.stringBytes;
+    }
+
+    bool stringsInBounds() const {
+        for (uint32_t i = 0; i < header.playerCount; ++i) {
+            const PlayerRecord& p = playerRecords[i];
+            if (!inStrings(p.username) || !inStrings(p.university)) return false;
+        }
+        for (uint32_t i = 0; i < header.wildcardCount; ++i) {
+            const WildcardRecord& w = wildcardRecords[i];
+            if (!inStrings(w.code) || !inStrings(w.username) || !inStrings(w.university)) return false;
+        }
+        return true;
+    }
+
+public:
+    // Map filename and check it is intact, still matches both CSV files and has
+    // every string inside the string table. False means: use the CSV files.
+    bool open(const string& filename, const string& playerCsv, const string& wildcardCsv) {
+        if (!file.open(filename) || file.size() < sizeof(SnapshotHeader)) return false;
+        memcpy(&header, file.begin(), sizeof(header));
+        if (memcmp(header.magic, "APUS", 4) != 0 || header.version != SnapshotVersion) return false;
+
+        size_t expected = sizeof(SnapshotHeader) + (size_t)header.playerCount * sizeof(PlayerRecord) +
+                          (size_t)header.wildcardCount * sizeof(WildcardRecord) + header.stringBytes;
+        if (file.size() != expected) return false;
+
+        uint64_t playerSize, wildcardSize, playerHash, wildcardHash;
+        if (!fileSignature(playerCsv, playerSize, playerHash) ||
+            !fileSignature(wildcardCsv, wildcardSize, wildcardHash) ||
+            playerSize != header.playerCsvSize || playerHash != header.playerCsvHash ||
+            wildcardSize != header.wildcardCsvSize || wildcardHash != header.wildcardCsvHash) {
+            return false;
+        }
+
+        // Checksum with the checksum field itself zeroed
+        uint64_t stored = header.checksum;
+        string headerCopy(file.begin(), sizeof(SnapshotHeader));
+        memset(&headerCopy[offsetof(SnapshotHeader, checksum)], 0, sizeof(uint64_t));
+        const char* body = file.begin() + sizeof(SnapshotHeader);
+        uint64_t h = snapshotChecksum(headerCopy.data(), headerCopy.size());
+        h = snapshotChecksum(body, file.size() - sizeof(SnapshotHeader), h);
+        if (h != stored) return false;
+
+        playerRecords = (const PlayerRecord*)body;
+        wildcardRecords = (const WildcardRecord*)(body + header.playerCount * sizeof(PlayerRecord));
+        strings = (const char*)(wildcardRecords + header.wildcardCount);
+        // The checksum only shows the file is as written; a bad offset from the
+        // writer would still send str() outside the file
+        return stringsInBounds();
+    }
+
+    uint32_t playerCount() const { return header.playerCount; }
+    uint32_t wildcardCount() const { return header.wildcardCount; }
+    int nextID() const { return header.nextID; }
+    const PlayerRecord& player(size_t i) const { return playerRecords[i]; }
+    const WildcardRecord& wildcard(size_t i) const { return wildcardRecords[i]; }
+
+    string_view str(uint32_t offset) const {
+        uint32_t length;
+        memcpy(&length, strings + offset, sizeof(length));
+        return string_view(strings + offset + sizeof(length), length);
+    }
+};
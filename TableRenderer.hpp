@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// Output formats for listings: the boxed console table, tab-separated values with
+// a header line, or one JSON object per line
+enum class OutputFormat { Table, Tsv, JsonLines };
+
+inline bool parseOutputFormat(string_view text, OutputFormat& format) {
+    if (text == "table") format = OutputFormat::Table;
+    else if (text == "tsv") format = OutputFormat::Tsv;
+    else if (text == "json") format = OutputFormat::JsonLines;
+    else return false;
+    return true;
+}
+
+struct Column {
+    const char* title;  // table heading
+    const char* key;    // TSV heading / JSON field name
+    int width;          // table cell width; longer values are not cut
+};
+
+// Box drawing for the table format: every row is open + cells joined by separator + close
+struct TableStyle {
+    const char* open;
+    const char* separator;
+    const char* close;
+    int ruleWidth;
+};
+
+// Formats rows into one reusable buffer and hands it to the stream in large
+// writes, instead of a chain of setw/operator<< calls per cell
+class TableRenderer {
+private:
+    ostream& out;
+    OutputFormat format;
+    const Column* columns;
+    int columnCount;
+    TableStyle style;
+    string buffer;
+    int cellIndex = 0;
+    static const size_t FlushBytes = 1 << 16;
+
+    void beginCell() {
+        if (format == OutputFormat::Table) {
+            buffer += cellIndex == 0 ? style.open : style.separator;
+        } else if (format == OutputFormat::Tsv) {
+            if (cellIndex > 0) buffer += '\t';
+        } else {
+            buffer += cellIndex == 0 ? "{\"" : ",\"";
+            buffer += columns[cellIndex].key;
+            buffer += "\":";
+        }
+    }
+
+    void pad(size_t written) {
+        size_t width = (size_t)columns[cellIndex].width;
+        if (written < width) buffer.append(width - written, ' ');
+    }
+
+    void appendQuoted(string_view text) {
+        buffer += '"';
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                buffer += '\\';
+                buffer += c;
+            } else if ((unsigned char)c < 0x20) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)c);
+                buffer += escaped;
+            } else {
+                buffer += c;
+            }
+        }
+        buffer += '"';
+    }
+
+    void rule(char c) {
+        buffer.append(style.ruleWidth, c);
+        buffer += '\n';
+    }
+
+public:
+    TableRenderer(ostream& stream, OutputFormat outputFormat, const Column* cols, int count, const TableStyle& tableStyle)
+        : out(stream), format(outputFormat), columns(cols), columnCount(count), style(tableStyle) {
+        buffer.reserve(FlushBytes + 1024);
+    }
+
+    ~TableRenderer() { flush(); }
+
+    TableRenderer(const TableRenderer&) = delete;
+    TableRenderer& operator=(const TableRenderer&) = delete;
+
+    void header() {
+        if (format == OutputFormat::Table) {
+            buffer += '\n';
+            rule('=');
+            for (int i = 0; i < columnCount; ++i) cell(columns[i].title);
+            endRow();
+            rule('-');
+        } else if (format == OutputFormat::Tsv) {
+            for (int i = 0; i < columnCount; ++i) {
+                if (i > 0) buffer += '\t';
+                buffer += columns[i].key;
+            }
+            buffer += '\n';
+        }
+    }
+
+    TableRenderer& cell(string_view text) {
+        beginCell();
+        if (format == OutputFormat::JsonLines) {
+            appendQuoted(text);
+        } else if (format == OutputFormat::Tsv) {
+            for (char c : text) buffer += (c == '\t' || c == '\n' || c == '\r') ? ' ' : c;
+        } else {
+            buffer.append(text.data(), text.size());
+            pad(text.size());
+        }
+        cellIndex++;
+        return *this;
+    }
+
+    TableRenderer& cell(long long value) {
+        beginCell();
+        char digits[24];
+        int length = snprintf(digits, sizeof(digits), "%lld", value);
+        buffer.append(digits, length);
+        if (format == OutputFormat::Table) pad(length);
+        cellIndex++;
+        return *this;
+    }
+
+    // A yes/no value: shown as the given words, or true/false in JSON
+    TableRenderer& cell(bool value, const char* yes, const char* no) {
+        if (format != OutputFormat::JsonLines) return cell(string_view(value ? yes : no));
+        beginCell();
+        buffer += value ? "true" : "false";
+        cellIndex++;
+        return *this;
+    }
+
+    void endRow() {
+        if (format == OutputFormat::Table) buffer += style.close;
+        else if (format == OutputFormat::JsonLines) buffer += '}';
+        buffer += '\n';
+        cellIndex = 0;
+        if (buffer.size() >= FlushBytes) flush();
+    }
+
+    void footer() {
+        if (format == OutputFormat::Table) rule('=');
+        flush();
+    }
+
+    void flush() {
+        if (buffer.empty()) return;
+        out.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+};
@@ -7,16 +7,141 @@
 #include <cctype> 
 #include <algorithm>
 #include "Task2.hpp"
+#include "ScriptRunner.hpp"
+#include "TournamentRegistry.hpp"
 using namespace std;
 
-int main() {
+// Headless mode: Task2 --script <file|-> [--dry-run]
+// Runs the commands against the tournament files and reports throughput on stderr.
+// With --dry-run the files are read but nothing is journaled or saved.
+int runScript(const string& script, bool dryRun) {
+    CircularQueue queue;
+    WildcardQueue wildcardQueue;
+    TournamentStore store(queue, wildcardQueue, "player.csv", "wildcard.csv");
+    if (dryRun) {
+        wildcardQueue.loadFromCSV("wildcard.csv");
+        queue.loadFromCSV("player.csv");
+    } else {
+        store.recover(4096); // a script is one unit of work: fsync in large groups
+    }
+
+    ScriptRunner runner(queue, wildcardQueue);
+    ScriptStats stats = runner.runFile(script, cout);
+    if (!dryRun) {
+        store.compact(true);
+        StatsFile("tournament.stats").write(queue, wildcardQueue);
+    }
+
+    cerr << stats.commands << " commands (" << stats.failed << " failed) in "
+         << fixed << setprecision(3) << stats.seconds << " s, "
+         << setprecision(0) << stats.opsPerSecond() << " ops/sec\n";
+    return stats.failed > 0 ? 1 : 0;
+}
+
+// Multi-tournament headless mode: Task2 --registry <manifest> --script <file|->
+// The manifest lists name,capacity per tournament. Every script line starts with the
+// tournament it is for (e.g. "valorant,register,Alice,3,APU"); each tournament's
+// commands run on its own shard, in parallel with the others.
+int runRegistryScript(const string& manifest, const string& script) {
+    TournamentRegistry registry;
+    if (registry.loadManifest(manifest) == 0) {
+        cerr << "No tournaments in " << manifest << "\n";
+        return 1;
+    }
+    registry.recoverAll(4096);
+
+    string text;
+    MappedFile file;
+    if (script == "-") {
+        text.assign(istreambuf_iterator<char>(cin), istreambuf_iterator<char>());
+    } else if (file.open(script)) {
+        text.assign(file.begin(), file.size());
+    } else {
+        cerr << "Cannot open script " << script << "\n";
+        return 1;
+    }
+
+    // Split the script into one command list per tournament
+    vector<string> names = registry.names();
+    vector<string> commands(names.size());
+    HashIndex<string, int> position;   // name -> 1 + index in names
+    for (size_t i = 0; i < names.size(); ++i) position.insert(names[i], (int)i + 1);
+    size_t unknown = 0;
+    for (size_t start = 0; start < text.size();) {
+        size_t end = text.find('\n', start);
+        if (end == string::npos) end = text.size();
+        string_view line(text.data() + start, end - start);
+        start = end + 1;
+        size_t comma = line.find(',');
+        if (line.empty() || line[0] == '#' || line == "\r") continue;
+        int at = (comma == string_view::npos) ? 0 : position.find(string(line.substr(0, comma)));
+        if (!at) {
+            unknown++;
+            continue;
+        }
+        commands[at - 1].append(line.substr(comma + 1)).push_back('\n');
+    }
+
+    vector<ostringstream> outputs(names.size());
+    vector<future<ScriptStats>> results;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < names.size(); ++i) {
+        results.push_back(registry.submit(names[i], [&commands, &outputs, i](Tournament& t) {
+            ScriptRunner runner(t.queue, t.wildcards);
+            return runner.run(commands[i].data(), commands[i].data() + commands[i].size(), outputs[i]);
+        }));
+    }
+    ScriptStats total;
+    total.failed = unknown;
+    for (size_t i = 0; i < names.size(); ++i) {
+        ScriptStats stats = results[i].get();
+        total.commands += stats.commands;
+        total.failed += stats.failed;
+        if (stats.commands > 0) cout << "== " << names[i] << " ==\n" << outputs[i].str();
+    }
+    total.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    registry.compactAll();
+
+    cerr << registry.size() << " tournaments on " << registry.shardCount() << " shards: "
+         << total.commands << " commands (" << total.failed << " failed) in "
+         << fixed << setprecision(3) << total.seconds << " s, "
+         << setprecision(0) << total.opsPerSecond() << " ops/sec\n";
+    return total.failed > 0 ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    string manifest;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (string(argv[i]) == "--registry") manifest = argv[i + 1];
+    }
+    for (int i = 1; i < argc; ++i) {
+        if (string(argv[i]) == "--script" && i + 1 < argc) {
+            if (!manifest.empty()) return runRegistryScript(manifest, argv[i + 1]);
+            bool dryRun = false;
+            for (int j = 1; j < argc; ++j) dryRun = dryRun || string(argv[j]) == "--dry-run";
+            return runScript(argv[i + 1], dryRun);
+        }
+    }
+
     CircularQueue queue;
     WildcardQueue wildcardQueue;
     string filename = "player.csv";
-    wildcardQueue.loadFromCSV("wildcard.csv");
+    TournamentStore store(queue, wildcardQueue, filename, "wildcard.csv");
+    store.recover();
+    // Nothing between menu choices waits on the disk: the journal is made durable
+    // within 200 ms (or 64 changes), and the stats file goes the same way
+    store.startWriteBehind(chrono::milliseconds(200), 64);
+    StatsFile statsFile("tournament.stats");
+    statsFile.writeBehind(store.writeBehind());
 
-    queue.loadFromCSV(filename);
-    queue.updateTournamentStatus();
+    // Announce players crossing the line, e.g. when a withdrawal frees a slot
+    queue.setAdmissionListener([](const AdmissionEvent& e) {
+        if (e.kind == AdmissionEvent::Promoted) {
+            cout << "Player ID " << e.playerID << " moved up from the waitlist into the tournament.\n";
+        } else {
+            cout << "Player ID " << e.playerID << " moved from the tournament to the waitlist.\n";
+        }
+    });
 
     bool running = true;
     string userRole = "";
@@ -96,20 +221,23 @@ int main() {
             }
         }
         else if (choice == 4) {
-            queue.saveAllToCSV(filename);
-            wildcardQueue.saveToCSV("wildcard.csv");
+            store.compact(true);
+            statsFile.write(queue, wildcardQueue);
+            store.flush();
             cout << "Exiting program.\n";
             return 0;
         }
         else {
             cout << "Invalid choice.\n";
         }
+        store.commit();
+        statsFile.tick(queue, wildcardQueue);
     }
 
     while (running) {
         if (userRole == "admin") {
             cout << "\n--- Admin Menu ---\n";
-            cout << "1. Register Player\n2. Display All Players\n3. Check-In Player\n4. Withdraw Player\n5. Edit Player Info\n6. Make Wildcard\n7. View All Wildcard Entries\n8. Exit\nEnter choice: ";
+            cout << "1. Register Player\n2. Display All Players\n3. Check-In Player\n4. Withdraw Player\n5. Edit Player Info\n6. Make Wildcard\n7. View All Wildcard Entries\n8. Exit\n9. Search Player by Username\n10. View System Metrics\n11. Rank Leaderboard\nEnter choice: ";
             int ch, id, rank;
             string name, uni;
             cin >> ch;
@@ -154,7 +282,28 @@ int main() {
 
                 queue.enqueue(name, rank, uni);
             } else if (ch == 2) {
-                queue.display();
+                cout << "Show: 1. All Players  2. In Tournament  3. Waitlist\nEnter choice: ";
+                int viewChoice;
+                cin >> viewChoice;
+                cin.ignore();
+                PlayerView view = viewChoice == 2 ? PlayerView::Tournament
+                                : viewChoice == 3 ? PlayerView::Waitlist : PlayerView::All;
+
+                // Large rosters are shown a page at a time
+                const size_t pageSize = 50;
+                size_t total = queue.countOf(view);
+                if (total == 0) {
+                    cout << "No players to show.\n";
+                }
+                for (size_t offset = 0; offset < total; offset += pageSize) {
+                    queue.display(view, offset, pageSize);
+                    if (offset + pageSize >= total) break;
+                    cout << "Rows " << offset + 1 << "-" << offset + pageSize << " of " << total
+                         << ". Press Enter for more, q to stop: ";
+                    string answer;
+                    getline(cin, answer);
+                    if (answer == "q" || answer == "Q") break;
+                }
             } else if (ch == 3) {
                 cout << "Enter Player ID to check-in: "; cin >> id;
                 queue.checkIn(id);
@@ -162,8 +311,8 @@ int main() {
                 cout << "Enter Player ID to withdraw: "; cin >> id;
                 queue.withdraw(id);
             } else if (ch == 8) {
-                queue.saveAllToCSV(filename);
-                wildcardQueue.saveToCSV("wildcard.csv");
+                store.compact(true);
+                store.flush();
                 cout << "Exiting admin mode.\n";
                 break;
             } else if (ch == 6) {
@@ -187,12 +336,42 @@ int main() {
                 cin.ignore();
                 if (queue.exists(id)) {
                     queue.editPlayerInfo(id);
-                    // queue.saveAllToCSV(filename);
                 } else {
                     cout << "Player ID not found.\n";
                 }
             } else if (ch == 7) {
                 wildcardQueue.displayWildcards();
+            } else if (ch == 10) {
+                cout << "\n";
+                writeStats(cout, queue, wildcardQueue);
+            } else if (ch == 11) {
+                int k;
+                cout << "How many top players to show: ";
+                cin >> k;
+                cin.ignore();
+                if (k <= 0 || queue.countOf(PlayerView::All) == 0) {
+                    cout << "No players to show.\n";
+                } else {
+                    queue.display(queue.topByRank((size_t)k));
+                    int low, high;
+                    cout << "Count players in a rank band - lowest and highest rank: ";
+                    if (cin >> low >> high) {
+                        cout << queue.countRankBetween(low, high) << " players ranked " << low << "-" << high << ".\n";
+                    }
+                    cin.clear();
+                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                }
+            } else if (ch == 9) {
+                string prefix;
+                cout << "Enter username or the start of one: ";
+                getline(cin, prefix);
+                vector<const Player*> matches = queue.searchUsername(prefix);
+                if (matches.empty()) {
+                    cout << "No players found.\n";
+                } else {
+                    queue.display(matches);
+                    if (matches.size() == 50) cout << "Showing the first 50 matches.\n";
+                }
             } else {
                 cout << "Invalid choice!\n";
             }
@@ -210,13 +389,13 @@ int main() {
                 queue.checkIn(currentPlayerID);
             } else if (ch == 3) {
                 queue.withdraw(currentPlayerID);
-                queue.saveAllToCSV(filename);
+                store.commit();
                 cout << "You have been withdrawn. Exiting player mode.\n";
                 break;
             } else if (ch == 5) {
-                queue.saveAllToCSV(filename);
+                store.compact(true);
+                store.flush();
                 cout << "Exiting player mode.\n";
-                wildcardQueue.saveToCSV("wildcard.csv");
                 break;
             } else if (ch == 4) {
                 queue.editPlayerInfo(currentPlayerID);
@@ -225,6 +404,8 @@ int main() {
             }
             
         }
+        store.commit();
+        statsFile.tick(queue, wildcardQueue);
     }
     return 0;
 }
\ No newline at end of file
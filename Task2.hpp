@@ -1,3 +1,5 @@
+#pragma once
+
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -6,469 +8,2158 @@
 #include <sstream>
 #include <cctype> 
 #include <algorithm>
+#include <vector>
+#include <functional>
+#include <memory>
+#include <new>
+#include <utility>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include "CsvReader.hpp"
+#include "Journal.hpp"
+#include "Snapshot.hpp"
+#include "TableRenderer.hpp"
+#include "Bitmap.hpp"
+#include "Metrics.hpp"
+#include "Persister.hpp"
 using namespace std;
 
+// Open-addressing hash map (linear probing) used to look nodes up by key in O(1) on average
+template <typename Key, typename Value>
+class HashIndex {
+private:
+    enum SlotState : unsigned char { EMPTY, FULL, DELETED };
+
+    vector<Key> keys;
+    vector<Value> values;
+    vector<unsigned char> states;
+    size_t count = 0;   // live entries
+    size_t used = 0;    // live entries + tombstones
+
+    size_t slotFor(const Key& key) const {
+        // Fibonacci hashing spreads sequential IDs across the table
+        unsigned long long h = hash<Key>()(key);
+        return (size_t)((h * 0x9E3779B97F4A7C15ULL) >> 16) & (states.size() - 1);
+    }
+
+    void rehash(size_t newCapacity) {
+        vector<Key> oldKeys = move(keys);
+        vector<Value> oldValues = move(values);
+        vector<unsigned char> oldStates = move(states);
+
+        keys.assign(newCapacity, Key());
+        values.assign(newCapacity, Value());
+        states.assign(newCapacity, EMPTY);
+        count = used = 0;
+
+        for (size_t i = 0; i < oldStates.size(); ++i) {
+            if (oldStates[i] == FULL) insert(oldKeys[i], oldValues[i]);
+        }
+    }
+
+public:
+    HashIndex() { rehash(16); }
+
+    size_t size() const { return count; }
+
+    Value find(const Key& key) const {
+        size_t mask = states.size() - 1;
+        for (size_t i = slotFor(key); states[i] != EMPTY; i = (i + 1) & mask) {
+            if (states[i] == FULL && keys[i] == key) return values[i];
+        }
+        return Value();
+    }
+
+    void insert(const Key& key, Value value) {
+        // Keep the load factor (tombstones included) under 70%: grow when mostly
+        // live entries, otherwise rehash in place to clear tombstones
+        if ((used + 1) * 10 > states.size() * 7) {
+            rehash(count * 4 >= states.size() ? states.size() * 2 : states.size());
+        }
+        size_t mask = states.size() - 1;
+        size_t tombstone = states.size();
+        size_t i = slotFor(key);
+        for (; states[i] != EMPTY; i = (i + 1) & mask) {
+            if (states[i] == FULL && keys[i] == key) {
+                values[i] = value;
+                return;
+            }
+            if (states[i] == DELETED && tombstone == states.size()) tombstone = i;
+        }
+        if (tombstone != states.size()) {
+            i = tombstone;
+        } else {
+            used++;
+        }
+        keys[i] = key;
+        values[i] = value;
+        states[i] = FULL;
+        count++;
+    }
+
+    bool erase(const Key& key) {
+        size_t mask = states.size() - 1;
+        for (size_t i = slotFor(key); states[i] != EMPTY; i = (i + 1) & mask) {
+            if (states[i] == FULL && keys[i] == key) {
+                states[i] = DELETED;
+                keys[i] = Key();
+                values[i] = Value();
+                count--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void clear() { rehash(16); }
+
+    // Size the table for at least n entries up front (bulk loads)
+    void reserve(size_t n) {
+        size_t capacity = 16;
+        while (capacity * 7 < n * 10) capacity *= 2;
+        if (capacity > states.size()) rehash(capacity);
+    }
+};
+
+// Ordered map (skip list) used to keep entries sorted with O(log n) insert and erase.
+// Every link also records how many entries it skips, so entries can be reached by
+// position in O(log n) as well. Keys are expected to be unique.
+template <typename Key, typename Value>
+class SkipList {
+private:
+    static const int MaxLevel = 24;
+
+    struct Node;
+    struct Link {
+        Node* next;
+        size_t span;    // entries passed by following this link (to the end if next is null)
+    };
+
+    struct Node {
+        Key key;
+        Value value;
+        vector<Link> forward;
+
+        Node(const Key& k, Value v, int level) : key(k), value(v), forward(level, Link{nullptr, 0}) {}
+    };
+
+    Node head;
+    int level = 1;
+    size_t count = 0;
+    unsigned int seed = 2463534242u;
+
+    int randomLevel() {
+        // xorshift32; each level is kept with probability 1/4
+        int lvl = 1;
+        while (lvl < MaxLevel) {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            if ((seed & 3) != 0) break;
+            lvl++;
+        }
+        return lvl;
+    }
+
+    // Fill update[] with the rightmost node before key on every level, and rank[]
+    // with the number of entries up to and including that node
+    void findPredecessors(const Key& key, Node** update, size_t* rank) {
+        Node* x = &head;
+        size_t traversed = 0;
+        for (int i = level - 1; i >= 0; --i) {
+            while (x->forward[i].next && x->forward[i].next->key < key) {
+                traversed += x->forward[i].span;
+                x = x->forward[i].next;
+            }
+            update[i] = x;
+            rank[i] = traversed;
+        }
+    }
+
+public:
+    SkipList() : head(Key(), Value(), MaxLevel) {}
+    ~SkipList() { clear(); }
+
+    SkipList(const SkipList&) = delete;
+    SkipList& operator=(const SkipList&) = delete;
+
+    size_t size() const { return count; }
+
+    // Insert and return the value of the entry now preceding it (Value() if it is first)
+    Value insert(const Key& key, Value value) {
+        Node* update[MaxLevel];
+        size_t rank[MaxLevel];
+        findPredecessors(key, update, rank);
+
+        int lvl = randomLevel();
+        if (lvl > level) {
+            for (int i = level; i < lvl; ++i) {
+                update[i] = &head;
+                rank[i] = 0;
+                head.forward[i].span = count;
+            }
+            level = lvl;
+        }
+        Node* node = new Node(key, value, lvl);
+        for (int i = 0; i < lvl; ++i) {
+            node->forward[i].next = update[i]->forward[i].next;
+            update[i]->forward[i].next = node;
+            node->forward[i].span = update[i]->forward[i].span - (rank[0] - rank[i]);
+            update[i]->forward[i].span = rank[0] - rank[i] + 1;
+        }
+        for (int i = lvl; i < level; ++i) update[i]->forward[i].span++;
+        count++;
+        return update[0] == &head ? Value() : update[0]->value;
+    }
+
+    bool erase(const Key& key) {
+        Node* update[MaxLevel];
+        size_t rank[MaxLevel];
+        findPredecessors(key, update, rank);
+
+        Node* node = update[0]->forward[0].next;
+        if (!node || key < node->key || node->key < key) return false;
+        for (int i = 0; i < level; ++i) {
+            if (update[i]->forward[i].next == node) {
+                update[i]->forward[i].span += node->forward[i].span - 1;
+                update[i]->forward[i].next = node->forward[i].next;
+            } else {
+                update[i]->forward[i].span--;
+            }
+        }
+        while (level > 1 && !head.forward[level - 1].next) level--;
+        delete node;
+        count--;
+        return true;
+    }
+
+    Value first() const { return head.forward[0].next ? head.forward[0].next->value : Value(); }
+
+    // Value of the entry at position (0 = first), or Value() if out of range
+    Value at(size_t position) const {
+        if (position >= count) return Value();
+        const Node* x = &head;
+        size_t traversed = 0;
+        for (int i = level - 1; i >= 0; --i) {
+            while (x->forward[i].next && traversed + x->forward[i].span <= position + 1) {
+                traversed += x->forward[i].span;
+                x = x->forward[i].next;
+            }
+            if (traversed == position + 1) return x->value;
+        }
+        return Value();
+    }
+
+    // Number of entries whose key is below key, in O(log n)
+    size_t countBelow(const Key& key) const {
+        const Node* x = &head;
+        size_t traversed = 0;
+        for (int i = level - 1; i >= 0; --i) {
+            while (x->forward[i].next && x->forward[i].next->key < key) {
+                traversed += x->forward[i].span;
+                x = x->forward[i].next;
+            }
+        }
+        return traversed;
+    }
+
+    // Replace the contents with entries already in ascending key order, in O(n)
+    void assignSorted(const vector<pair<Key, Value>>& entries) {
+        clear();
+        Node* tails[MaxLevel];
+        size_t tailRank[MaxLevel];
+        for (int i = 0; i < MaxLevel; ++i) {
+            tails[i] = &head;
+            tailRank[i] = 0;
+        }
+        size_t rank = 0;
+        for (const auto& entry : entries) {
+            rank++;
+            int lvl = randomLevel();
+            if (lvl > level) level = lvl;
+            Node* node = new Node(entry.first, entry.second, lvl);
+            for (int i = 0; i < lvl; ++i) {
+                tails[i]->forward[i].next = node;
+                tails[i]->forward[i].span = rank - tailRank[i];
+                tails[i] = node;
+                tailRank[i] = rank;
+            }
+        }
+        count = entries.size();
+        for (int i = 0; i < MaxLevel; ++i) tails[i]->forward[i].span = count - tailRank[i];
+    }
+
+    template <typename Visitor>
+    void forEach(Visitor visit) const {
+        for (Node* x = head.forward[0].next; x; x = x->forward[0].next) visit(x->key, x->value);
+    }
+
+    // visit(key, value) in order from the first entry not below from, for as long
+    // as visit returns true
+    template <typename Visitor>
+    void forEachFrom(const Key& from, Visitor visit) const {
+        const Node* x = &head;
+        for (int i = level - 1; i >= 0; --i) {
+            while (x->forward[i].next && x->forward[i].next->key < from) x = x->forward[i].next;
+        }
+        for (const Node* n = x->forward[0].next; n && visit(n->key, n->value); n = n->forward[0].next) {}
+    }
+
+    void clear() {
+        Node* x = head.forward[0].next;
+        while (x) {
+            Node* nextNode = x->forward[0].next;
+            delete x;
+            x = nextNode;
+        }
+        for (int i = 0; i < MaxLevel; ++i) head.forward[i] = Link{nullptr, 0};
+        level = 1;
+        count = 0;
+    }
+};
+
+// Registration times are kept as epoch seconds and only rendered as
+// "YYYY-MM-DD HH:MM:SS" (local time) when they are displayed or saved
+
+// Time parser that cleans up \r or other trailing characters
+inline time_t parseTime(const string& timeStr) {
+    struct tm t = {};
+    string cleanedTime = timeStr;
+    cleanedTime.erase(remove(cleanedTime.begin(), cleanedTime.end(), '\r'), cleanedTime.end());
+    istringstream ss(cleanedTime);
+    ss >> get_time(&t, "%Y-%m-%d %H:%M:%S");
+    if (ss.fail()) {
+        cout << "Failed to parse time: [" << timeStr << "]\n";
+        return time(0);
+    }
+    t.tm_isdst = -1;
+    return mktime(&t);
+}
+
+// localtime into a caller-owned tm, so shards can format times at the same time
+inline tm localTime(time_t when) {
+    tm result = {};
+#if defined(_WIN32)
+    localtime_s(&result, &when);
+#else
+    localtime_r(&when, &result);
+#endif
+    return result;
+}
+
+// formatTime into buf (20 bytes) for listings. Rows come in registration order, so
+// localtime only runs once per distinct minute and the seconds are filled in here.
+inline void formatTimeTo(time_t when, char* buf) {
+    thread_local time_t cachedMinute = -1;
+    thread_local char cached[20];
+    long long second = ((long long)when % 60 + 60) % 60;
+    time_t minute = when - (time_t)second;
+    if (minute != cachedMinute) {
+        tm ltm = localTime(minute);
+        strftime(cached, sizeof(cached), "%Y-%m-%d %H:%M:%S", &ltm);
+        cachedMinute = minute;
+    }
+    memcpy(buf, cached, 17);
+    buf[17] = (char)('0' + second / 10);
+    buf[18] = (char)('0' + second % 10);
+    buf[19] = '\0';
+}
+
+inline string formatTime(time_t when) {
+    char buf[20];
+    formatTimeTo(when, buf);
+    return string(buf, 19);
+}
+
+// Hands out registration times. The clock is the wall time at startup advanced by
+// steady_clock, so stamps never go backwards, and a wall clock stepped back or
+// forward while the program runs does not move them. A player loaded or replayed
+// with a time slightly ahead of the clock (another machine's clock, say) moves it
+// forward to that time, so seeding by time stays seeding by arrival; times more
+// than MaxAhead ahead are not believed and leave the clock alone. Players stamped
+// within the same second are ordered by ID, which is issued in the same order, so
+// (time, ID) is an exact total order of sign-ups without storing anything finer
+// than seconds.
+class RegistrationClock {
+private:
+    time_t base;                        // wall time at start, plus forward moves
+    chrono::steady_clock::time_point start;
+
+public:
+    static const time_t MaxAhead = 300;
+
+    RegistrationClock() : base(time(0)), start(chrono::steady_clock::now()) {}
+
+    time_t now() const {
+        return base + (time_t)chrono::duration_cast<chrono::seconds>(chrono::steady_clock::now() - start).count();
+    }
+
+    // A loaded or replayed player registered at when; later stamps stay after them
+    void observe(time_t when) {
+        time_t current = now();
+        if (when > current && when - current <= MaxAhead) base += when - current;
+    }
+};
+
+// Slab allocator for list nodes. Nodes are carved out of contiguous blocks so that
+// walking a list touches memory in order, and freed slots are recycled before new
+// blocks are requested.
+template <typename T, size_t BlockSize = 256>
+class NodePool {
+private:
+    union Slot {
+        Slot* nextFree;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    vector<Slot*> blocks;
+    Slot* freeList = nullptr;
+    size_t used = 0;      // slots handed out from the newest block
+    size_t capacity = 0;  // slots in the newest block
+    size_t reserved = 0;  // upcoming creates that must come from the newest block
+    size_t live = 0;
+
+    void addBlock(size_t slots) {
+        blocks.push_back(static_cast<Slot*>(::operator new(sizeof(Slot) * slots)));
+        capacity = slots;
+        used = 0;
+    }
+
+public:
+    NodePool() {}
+    ~NodePool() { releaseAll(); }
+
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    template <typename... Args>
+    T* create(Args&&... args) {
+        Slot* slot;
+        if (freeList && reserved == 0) {
+            slot = freeList;
+            freeList = freeList->nextFree;
+        } else {
+            if (used == capacity) addBlock(BlockSize);
+            slot = blocks.back() + used++;
+            if (reserved > 0) reserved--;
+        }
+        T* node = new (slot->storage) T(std::forward<Args>(args)...);
+        live++;
+        return node;
+    }
+
+    void destroy(T* node) {
+        node->~T();
+        Slot* slot = reinterpret_cast<Slot*>(node);
+        slot->nextFree = freeList;
+        freeList = slot;
+        live--;
+    }
+
+    // Make the next n nodes come out of one contiguous block (batch inserts).
+    // Whatever is left of the current block goes on the free list.
+    void reserve(size_t n) {
+        reserved = n;
+        if (capacity - used >= n) return;
+        for (size_t i = capacity; i > used; --i) {
+            Slot* slot = blocks.back() + (i - 1);
+            slot->nextFree = freeList;
+            freeList = slot;
+        }
+        addBlock(max(n, BlockSize));
+    }
+
+    // Free every block at once. Callers must have run the destructors of any
+    // nodes still alive (see CircularQueue::clear).
+    void releaseAll() {
+        for (Slot* block : blocks) ::operator delete(block);
+        blocks.clear();
+        freeList = nullptr;
+        used = capacity = reserved = 0;
+        live = 0;
+    }
+
+    size_t size() const { return live; }
+};
+
+// A string stored once in the StringPool. Equal texts share one entry, so they can
+// be compared, hashed or grouped by pointer or id instead of by characters.
+struct InternedString {
+    string text;
+    int id;                         // dense; reused once the entry is freed
+    mutable atomic<int> refs{1};    // StringRefs holding the entry
+};
+
+class StringRef;
+
+// Intern table shared by every queue. Entries are reference counted through
+// StringRef and freed with the last reference, so names of withdrawn players and
+// edited-away values do not pile up. An entry never moves while referenced, so
+// holders read it without locking. Lookups share a reader lock, so queues on
+// different threads only wait on each other when one of them adds a string not
+// in the table or drops the last reference to one.
+class StringPool {
+private:
+    HashIndex<string_view, InternedString*> lookup;     // keys view the entries' text
+    vector<int> freeIds;
+    int nextId = 0;
+    size_t live = 0;
+    mutable shared_mutex lock;
+
+public:
+    StringRef intern(string_view text);
+
+    // Drop one reference to entry, freeing it with the last one
+    void release(const InternedString* entry) {
+        // Never the last one while refs > 1, so no lock
+        int refs = entry->refs.load(memory_order_relaxed);
+        while (refs > 1) {
+            if (entry->refs.compare_exchange_weak(refs, refs - 1, memory_order_release, memory_order_relaxed)) return;
+        }
+        // Under the writer lock no one can find the entry and take a new reference
+        unique_lock<shared_mutex> guard(lock);
+        if (entry->refs.fetch_sub(1, memory_order_acq_rel) != 1) return;
+        lookup.erase(string_view(entry->text));
+        freeIds.push_back(entry->id);
+        live--;
+        delete entry;
+    }
+
+    // Id of the entry for text, or -1 if it is not in the table
+    int idOf(string_view text) const {
+        shared_lock<shared_mutex> guard(lock);
+        const InternedString* found = lookup.find(text);
+        return found ? found->id : -1;
+    }
+
+    size_t size() const {
+        shared_lock<shared_mutex> guard(lock);
+        return live;
+    }
+};
+
+// Never destroyed, so StringRefs in static objects can be released at any point
+// during shutdown
+inline StringPool& stringPool() {
+    static StringPool* pool = new StringPool;
+    return *pool;
+}
+
+// A counted reference to a StringPool entry. Copies share the entry; it is freed
+// when the last one goes. Converts to the entry pointer for comparisons and lookups.
+class StringRef {
+private:
+    const InternedString* entry = nullptr;
+
+public:
+    StringRef() {}
+    // Takes over a reference already counted for entry
+    explicit StringRef(const InternedString* counted) : entry(counted) {}
+    StringRef(const StringRef& other) : entry(other.entry) {
+        if (entry) entry->refs.fetch_add(1, memory_order_relaxed);
+    }
+    StringRef(StringRef&& other) : entry(other.entry) { other.entry = nullptr; }
+    StringRef& operator=(StringRef other) {
+        swap(entry, other.entry);
+        return *this;
+    }
+    ~StringRef() {
+        if (entry) stringPool().release(entry);
+    }
+
+    // A new reference to an entry someone else is holding
+    static StringRef share(const InternedString* held) {
+        held->refs.fetch_add(1, memory_order_relaxed);
+        return StringRef(held);
+    }
+
+    const InternedString* operator->() const { return entry; }
+    operator const InternedString*() const { return entry; }
+};
+
+inline StringRef StringPool::intern(string_view text) {
+    {
+        shared_lock<shared_mutex> guard(lock);
+        const InternedString* found = lookup.find(text);
+        if (found) return StringRef::share(found);
+    }
+    unique_lock<shared_mutex> guard(lock);
+    const InternedString* found = lookup.find(text);
+    if (found) return StringRef::share(found);
+    int id = nextId;
+    if (freeIds.empty()) {
+        nextId++;
+    } else {
+        id = freeIds.back();
+        freeIds.pop_back();
+    }
+    InternedString* entry = new InternedString{string(text), id};
+    lookup.insert(string_view(entry->text), entry);
+    live++;
+    return StringRef(entry);
+}
+
 struct Player {
     int playerID;
+    int rank;
+    StringRef username;
+    StringRef university;
+    time_t registrationTime;
+    Player* next;
+    Player* prev;
+    atomic<bool> checkInStatus;   // set lock-free by ConcurrentCircularQueue::checkIn
+    bool isWildcard;
+    bool inTournament;
+    bool joining = false;         // in the batch being registered
+    int slot;                     // dense number used by the queue's bitmap indexes
+
+    Player(int id, string_view user, int r, string_view uni, time_t regTime, bool wildcard, bool inTour)
+        : playerID(id), rank(r), username(stringPool().intern(user)), university(stringPool().intern(uni)),
+          registrationTime(regTime), next(nullptr), prev(nullptr),
+          checkInStatus(false), isWildcard(wildcard), inTournament(inTour), slot(-1) {}
+};
+
+// One entry of a batch registration (CircularQueue::enqueueBatch)
+struct Registration {
     string username;
     int rank;
     string university;
-    bool checkInStatus;
-    string registrationTime;
     bool isWildcard;
-    bool inTournament;
-    Player* next;
+    int playerID = 0;   // taken earlier with reserveIDs, or 0 for the next free one
+};
+
+// Outcome of a batch registration. Registrations without an ID got firstID,
+// firstID + 1, ... in batch order.
+struct BatchResult {
+    int firstID;
+    int count;      // players registered
+    int admitted;   // how many of them hold a tournament slot afterwards
+    int rejected;   // came with an ID someone already has; not registered
+};
+
+// Seeding policies. A policy decides the seeding order of a queue at compile time:
+// it names the Key the order is sorted by (whose operator< the skip list and every
+// merge inline), builds that key from a player, and sorts a batch registration
+// (one shared time, ascending IDs) into key order as cheaply as its rule allows.
+// The top capacity players in that order hold the tournament slots.
+
+// Default order: wildcards first, then earliest registration, then lowest ID.
+// IDs are handed out in registration order, so players registering within the same
+// second keep their arrival order.
+struct SeedKey {
+    bool isWildcard;
+    time_t registered;
+    int playerID;
+
+    constexpr bool operator<(const SeedKey& other) const {
+        return isWildcard != other.isWildcard ? isWildcard
+             : registered != other.registered ? registered < other.registered
+             : playerID < other.playerID;
+    }
+};
+
+struct WildcardThenTime {
+    typedef SeedKey Key;
+    static constexpr bool seedsByRank = false;
+
+    template <typename P>
+    static Key keyOf(const P* p) {
+        return Key{p->isWildcard, p->registrationTime, p->playerID};
+    }
 
-    Player(int id, string user, int r, string uni, string regTime, bool wildcard, bool inTour)
-        : playerID(id), username(user), rank(r), university(uni),
-          checkInStatus(false), registrationTime(regTime),
-          isWildcard(wildcard), inTournament(inTour), next(nullptr) {}
+    // Times and IDs already ascend, so putting the wildcards first sorts the batch
+    static void sortBatch(vector<Player*>& batch) {
+        stable_partition(batch.begin(), batch.end(), [](const Player* p) { return p->isWildcard; });
+    }
+};
+
+// Rank-seeded order: wildcards first, then best (lowest) rank, then the default
+// order. An edit that changes a player's rank moves them.
+struct RankSeedKey {
+    bool isWildcard;
+    int rank;
+    time_t registered;
+    int playerID;
+
+    constexpr bool operator<(const RankSeedKey& other) const {
+        return isWildcard != other.isWildcard ? isWildcard
+             : rank != other.rank ? rank < other.rank
+             : registered != other.registered ? registered < other.registered
+             : playerID < other.playerID;
+    }
+};
+
+struct RankSeeded {
+    typedef RankSeedKey Key;
+    static constexpr bool seedsByRank = true;
+
+    template <typename P>
+    static Key keyOf(const P* p) {
+        return Key{p->isWildcard, p->rank, p->registrationTime, p->playerID};
+    }
+
+    static void sortBatch(vector<Player*>& batch) {
+        stable_sort(batch.begin(), batch.end(), [](const Player* a, const Player* b) {
+            if (a->isWildcard != b->isWildcard) return a->isWildcard;
+            return a->rank < b->rank;
+        });
+    }
+};
+
+// Player listings and player.csv rows. Written for any type with Player's fields,
+// so versioned copies of players (RosterVersions.hpp) render the same way.
+constexpr Column playerColumns[] = {
+    {"ID", "id", 6}, {"Username", "username", 20}, {"Rank", "rank", 6},
+    {"University", "university", 20}, {"Registered", "registered", 19},
+    {"Status", "checked_in", 17}, {"Wildcard", "wildcard", 9}, {"Queue", "in_tournament", 20}
 };
+constexpr TableStyle playerTable = {"| ", " | ", " |", 142};
+
+template <typename P>
+void renderPlayerRow(TableRenderer& table, const P* p) {
+    char registered[20];
+    formatTimeTo(p->registrationTime, registered);
+    table.cell(p->playerID).cell(p->username->text).cell(p->rank).cell(p->university->text)
+         .cell(registered)
+         .cell((bool)p->checkInStatus, "Checked-In", "Not Checked-In")
+         .cell(p->isWildcard, "Yes", "No")
+         .cell(p->inTournament, "In Tournament", "Waiting");
+    table.endRow();
+}
+
+// id,username,rank,university,checkIn,registered,wildcard,inTournament
+template <typename P>
+void writePlayerCsvRow(ostream& file, const P* p) {
+    char registered[20];
+    formatTimeTo(p->registrationTime, registered);
+    file << p->playerID << "," << p->username->text << "," << p->rank << ","
+         << p->university->text << "," << (p->checkInStatus ? "1" : "0") << ","
+         << registered << "," << (p->isWildcard ? "1" : "0") << ","
+         << (p->inTournament ? "1" : "0") << "\n";
+}
 
-class CircularQueue {
+// The info card shown to a logged-in player
+template <typename P>
+void writePlayerInfo(ostream& out, const P* p) {
+    out << "\n" << string(50, '=') << "\n";
+    out << "Your Player Info\n";
+    out << string(50, '=') << "\n";
+    out << "ID           : " << p->playerID << "\n";
+    out << "Username     : " << p->username->text << "\n";
+    out << "Rank         : " << p->rank << "\n";
+    out << "University   : " << p->university->text << "\n";
+    out << "Registered   : " << formatTime(p->registrationTime) << "\n";
+    out << "Check-In     : " << (p->checkInStatus ? "Checked-In" : "Not Checked-In") << "\n";
+    out << "Wildcard     : " << (p->isWildcard ? "Yes" : "No") << "\n";
+    out << "Queue Status : " << (p->inTournament ? "In Tournament" : "Waiting") << "\n";
+    out << string(50, '=') << "\n";
+}
+
+// Leaderboard order: best (lowest) rank first, then lowest ID
+struct RankKey {
+    int rank;
+    int playerID;
+
+    bool operator<(const RankKey& other) const {
+        if (rank != other.rank) return rank < other.rank;
+        return playerID < other.playerID;
+    }
+};
+
+// A registered player gaining or losing a tournament slot because of someone
+// else's change: a withdrawal ahead of them, a better seed registering, a new
+// capacity. Registering itself is not an event.
+struct AdmissionEvent {
+    enum Kind { Promoted, Demoted };
+    Kind kind;
+    int playerID;
+};
+
+// Part of the seeding order a listing covers: everyone, the players holding a
+// tournament slot, or the waitlist behind them
+enum class PlayerView { All, Tournament, Waitlist };
+
+// Username index order: by name, then ID. The names view interned text, which
+// never moves.
+struct NameKey {
+    string_view username;
+    int playerID;
+
+    bool operator<(const NameKey& other) const {
+        if (username != other.username) return username < other.username;
+        return playerID < other.playerID;
+    }
+};
+
+// Player roster ordered by a seeding Policy (see above). DefaultSlots is the
+// number of tournament slots a queue starts with; a queue built with an explicit
+// slot count, or setCapacity, overrides it.
+template <typename Policy, int DefaultSlots = 12>
+class BasicCircularQueue {
 private:
+    typedef typename Policy::Key SeedOrder;
+
+
+    NodePool<Player> pool;
     Player* front;
     Player* rear;
-    int nextID;
-    const int maxSize = 12;
+    atomic<int> nextID;                 // see reserveIDs
+    int capacity;                       // tournament slots
     int size;
+    Journal* journal = nullptr;         // operation log, when attached
+    HashIndex<int, Player*> index;      // playerID -> node
+    SkipList<SeedOrder, Player*> order; // seeding order, mirrors the ring
+    SkipList<NameKey, Player*> byName;  // username search
+    SkipList<RankKey, Player*> byRank;  // leaderboard and rank statistics
+    Player* lastAdmitted = nullptr;     // last player holding a tournament slot
+    ostream* out = &cout;               // where messages and listings go
+    RegistrationClock registrationClock;
+    function<void(const AdmissionEvent&)> admissionListener;
+    vector<pair<Player*, bool>>* held = nullptr;  // events held back as (player, slot before)
+
+    // Secondary indexes for filtered queries: every live player owns a dense slot
+    // number and each bitmap holds one bit per slot
+    vector<Player*> slots;
+    vector<int> freeSlots;
+    Bitmap liveSet, checkedInSet, wildcardSet, tournamentSet;
+    vector<Bitmap> universitySets;
+    HashIndex<int, int> universitySet;  // interned university id -> 1 + position in universitySets
+
+    static SeedOrder keyOf(const Player* p) { return Policy::keyOf(p); }
 
-    string getCurrentTime() {
-        time_t now = time(0);
-        char buf[80];
-        tm* ltm = localtime(&now);
-        strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", ltm);
-        return buf;
+    // Insert a node into the seeding order and splice it into the ring at the same
+    // position, so the ring always runs from the top seed (front) to the last (rear)
+    void link(Player* newPlayer) {
+        Player* before = order.insert(keyOf(newPlayer), newPlayer);
+        if (!front) {
+            front = rear = newPlayer;
+            newPlayer->next = newPlayer->prev = newPlayer;
+        } else {
+            Player* after = before ? before->next : front;
+            Player* last = before ? before : rear;
+            last->next = newPlayer;
+            newPlayer->prev = last;
+            newPlayer->next = after;
+            after->prev = newPlayer;
+            if (!before) front = newPlayer;
+            if (before == rear) rear = newPlayer;
+        }
+        track(newPlayer);
+        size++;
+    }
+
+    void unlink(Player* curr) {
+        if (curr == front && curr == rear) {
+            front = rear = nullptr;
+        } else {
+            curr->prev->next = curr->next;
+            curr->next->prev = curr->prev;
+            if (curr == front) front = curr->next;
+            if (curr == rear) rear = curr->prev;
+        }
+        order.erase(keyOf(curr));
+        untrack(curr);
+        size--;
+    }
+
+    Bitmap& universityBits(const InternedString* university) {
+        int at = universitySet.find(university->id);
+        if (!at) {
+            universitySets.emplace_back();
+            at = (int)universitySets.size();
+            universitySet.insert(university->id, at);
+        }
+        return universitySets[at - 1];
+    }
+
+    // Give a player an ID index entry and a slot, and record them in the bitmaps
+    void track(Player* p) {
+        index.insert(p->playerID, p);
+        byName.insert(NameKey{p->username->text, p->playerID}, p);
+        byRank.insert(RankKey{p->rank, p->playerID}, p);
+        if (freeSlots.empty()) {
+            p->slot = (int)slots.size();
+            slots.push_back(p);
+        } else {
+            p->slot = freeSlots.back();
+            freeSlots.pop_back();
+            slots[p->slot] = p;
+        }
+        setBits(p);
+    }
+
+    void setBits(const Player* p) {
+        liveSet.set(p->slot);
+        checkedInSet.reserve(slots.size());  // markCheckedIn sets bits without growing
+        checkedInSet.assign(p->slot, p->checkInStatus);
+        wildcardSet.assign(p->slot, p->isWildcard);
+        tournamentSet.assign(p->slot, p->inTournament);
+        universityBits(p->university).set(p->slot);
+    }
+
+    // track() for a whole roster already in seeding order, on an empty queue: the
+    // ring, the seeding order and the name and rank lists are built from sorted
+    // arrays in O(n log n) overall, instead of a random skip list insert into each
+    // per player. Admission flags are left to the caller.
+    void trackSorted(const vector<pair<SeedOrder, Player*>>& sorted) {
+        size_t count = sorted.size();
+        if (count == 0) return;
+        index.reserve(count);
+        slots.reserve(count);
+        vector<pair<NameKey, Player*>> names;
+        vector<pair<RankKey, Player*>> ranks;
+        names.reserve(count);
+        ranks.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            Player* p = sorted[i].second;
+            p->next = sorted[(i + 1) % count].second;
+            p->next->prev = p;
+            index.insert(p->playerID, p);
+            p->slot = (int)slots.size();
+            slots.push_back(p);
+            setBits(p);
+            names.push_back(make_pair(NameKey{p->username->text, p->playerID}, p));
+            ranks.push_back(make_pair(RankKey{p->rank, p->playerID}, p));
+        }
+        auto byKey = [](const auto& a, const auto& b) { return a.first < b.first; };
+        sort(names.begin(), names.end(), byKey);
+        sort(ranks.begin(), ranks.end(), byKey);
+        byName.assignSorted(names);
+        byRank.assignSorted(ranks);
+        order.assignSorted(sorted);
+        front = sorted.front().second;
+        rear = sorted.back().second;
+        size = (int)count;
+    }
+
+    void untrack(Player* p) {
+        index.erase(p->playerID);
+        byName.erase(NameKey{p->username->text, p->playerID});
+        byRank.erase(RankKey{p->rank, p->playerID});
+        liveSet.reset(p->slot);
+        checkedInSet.reset(p->slot);
+        wildcardSet.reset(p->slot);
+        tournamentSet.reset(p->slot);
+        universityBits(p->university).reset(p->slot);
+        slots[p->slot] = nullptr;
+        freeSlots.push_back(p->slot);
+    }
+
+    // Make sure id is never handed out again
+    void observeID(int id) {
+        int next = nextID.load(memory_order_relaxed);
+        while (next <= id && !nextID.compare_exchange_weak(next, id + 1, memory_order_relaxed)) {}
+    }
+
+    void notifyAdmission(const Player* p) {
+        if (!admissionListener) return;
+        admissionListener(AdmissionEvent{p->inTournament ? AdmissionEvent::Promoted : AdmissionEvent::Demoted,
+                                         p->playerID});
+    }
+
+    // Changes a registered player's slot and reports it to the admission listener
+    void setInTournament(Player* p, bool value) {
+        if (p->inTournament == value) return;
+        p->inTournament = value;
+        tournamentSet.assign(p->slot, value);
+        if (p->joining) return;
+        if (held) {
+            held->push_back(make_pair(p, !value));
+        } else {
+            notifyAdmission(p);
+        }
+    }
+
+    // A newly linked player either takes a free slot or, if seeded above the
+    // current last slot holder, takes that slot and pushes them to the waitlist.
+    // Both are O(1): the slot holders are the front of the ring up to lastAdmitted
+    // and the waitlist is the rest, so only the boundary moves.
+    void admitNewPlayer(Player* p) {
+        bool admit = size <= capacity || keyOf(p) < keyOf(lastAdmitted);
+        p->inTournament = admit;                // joining is not an event
+        tournamentSet.assign(p->slot, admit);
+        if (size <= capacity) {
+            lastAdmitted = rear;
+        } else if (admit) {
+            setInTournament(lastAdmitted, false);
+            lastAdmitted = lastAdmitted->prev;
+        }
+    }
+
+    // A leaving tournament player hands their slot to the head of the waitlist
+    void releaseSlot(Player* p) {
+        if (!p->inTournament) return;
+        if (size > capacity) {
+            Player* waiting = lastAdmitted->next;
+            setInTournament(waiting, true);
+            lastAdmitted = waiting;
+        } else if (p == lastAdmitted) {
+            lastAdmitted = (size > 1) ? p->prev : nullptr;
+        }
+    }
+
+    // Merge a run of new, already sorted players into the ring in one pass, then
+    // rebuild the skip list and admission flags from the merged order
+    void mergeSortedRun(const vector<Player*>& run) {
+        vector<pair<SeedOrder, Player*>> merged;
+        merged.reserve(size + run.size());
+        size_t next = 0;
+        if (front) {
+            Player* curr = front;
+            do {
+                SeedOrder key = keyOf(curr);
+                while (next < run.size() && keyOf(run[next]) < key) {
+                    merged.push_back(make_pair(keyOf(run[next]), run[next]));
+                    next++;
+                }
+                merged.push_back(make_pair(key, curr));
+                curr = curr->next;
+            } while (curr != front);
+        }
+        for (; next < run.size(); ++next) merged.push_back(make_pair(keyOf(run[next]), run[next]));
+
+        size_t count = merged.size();
+        for (size_t i = 0; i < count; ++i) {
+            Player* p = merged[i].second;
+            p->next = merged[(i + 1) % count].second;
+            p->next->prev = p;
+        }
+        front = merged.front().second;
+        rear = merged.back().second;
+        for (Player* p : run) track(p);
+        order.assignSorted(merged);
+        size = (int)count;
+        updateTournamentStatus();
+    }
+
+
+public:
+    explicit BasicCircularQueue(int slots = DefaultSlots)
+        : front(nullptr), rear(nullptr), nextID(1000), capacity(max(1, slots)), size(0) {}
+    ~BasicCircularQueue() { clear(); }
+
+    BasicCircularQueue(const BasicCircularQueue&) = delete;
+    BasicCircularQueue& operator=(const BasicCircularQueue&) = delete;
+
+    // Drop every player. Node destructors run in ring order, then the pool hands
+    // its blocks back in one go instead of freeing node by node.
+    void clear() {
+        if (front) {
+            Player* curr = front;
+            do {
+                Player* nextPlayer = curr->next;
+                curr->~Player();
+                curr = nextPlayer;
+            } while (curr != front);
+        }
+        pool.releaseAll();
+        order.clear();
+        index.clear();
+        byName.clear();
+        byRank.clear();
+        slots.clear();
+        freeSlots.clear();
+        liveSet.clear();
+        checkedInSet.clear();
+        wildcardSet.clear();
+        tournamentSet.clear();
+        universitySets.clear();
+        universitySet.clear();
+        front = rear = lastAdmitted = nullptr;
+        size = 0;
+    }
+
+    // One player.csv row, viewing the mapped file:
+    // id,username,rank,university,checkIn,registered,wildcard,inTournament
+    struct PlayerRow {
+        int id, rank;
+        string_view username, university;
+        bool checkedIn, wildcard, inTournament;
+        time_t registered;
+    };
+
+    static bool parsePlayerRow(const string_view* fields, int count, PlayerRow& row) {
+        string_view field[8];
+        for (int i = 0; i < count && i < 8; ++i) field[i] = fields[i];
+        if (!parseInt(field[0], row.id) || !parseInt(field[2], row.rank)) return false;
+        row.username = field[1];
+        row.university = field[3];
+        row.checkedIn = (field[4] == "1");
+        if (!parseTimeFast(field[5], row.registered)) row.registered = parseTime(string(field[5]));
+        row.wildcard = (field[6] == "1");
+        row.inTournament = (field[7] == "1");
+        return true;
+    }
+
+    void loadFromCSV(const string& filename) {
+        APUEC_TIME(Operation::LoadCsv);
+        MappedFile file;
+        if (!file.open(filename)) return;
+
+        vector<PlayerRow> rows = parseCsvFile<PlayerRow>(file, parsePlayerRow);
+        if (rows.empty()) return;
+        pool.reserve(rows.size());
+        vector<Player*> loaded;
+        loaded.reserve(rows.size());
+        for (const PlayerRow& row : rows) {
+            Player* newPlayer = pool.create(
+                row.id, row.username, row.rank, row.university, row.registered,
+                row.wildcard, row.inTournament
+            );
+            newPlayer->checkInStatus = row.checkedIn;
+            loaded.push_back(newPlayer);
+            observeID(row.id);
+            registrationClock.observe(row.registered);
+        }
+
+        // Into an existing roster the rows are merged like a batch; into an empty
+        // one (the usual startup case) everything is built in bulk
+        if (front) {
+            sort(loaded.begin(), loaded.end(), [](const Player* a, const Player* b) { return keyOf(a) < keyOf(b); });
+            mergeSortedRun(loaded);
+            return;
+        }
+        vector<pair<SeedOrder, Player*>> sorted;
+        sorted.reserve(loaded.size());
+        for (Player* p : loaded) sorted.push_back(make_pair(keyOf(p), p));
+        auto byKey = [](const pair<SeedOrder, Player*>& a, const pair<SeedOrder, Player*>& b) {
+            return a.first < b.first;
+        };
+        if (!is_sorted(sorted.begin(), sorted.end(), byKey)) sort(sorted.begin(), sorted.end(), byKey);
+        trackSorted(sorted);
+        updateTournamentStatus();
+    }
+
+    void writeCSV(ostream& file) {
+        APUEC_TIME(Operation::SaveCsv);
+        if (!front) return;
+        Player* curr = front;
+        do {
+            writePlayerCsvRow(file, curr);
+            curr = curr->next;
+        } while (curr != front);
+    }
+
+    void saveAllToCSV(const string& filename) {
+        ofstream file(filename, ios::trunc);
+        if (!file.is_open()) return;
+        writeCSV(file);
+        file.close();
+    }
+
+    // Log every later change to journal (nullptr to stop logging)
+    void attachJournal(Journal* j) { journal = j; }
+
+    // Send confirmations and listings to stream instead of cout (buffered/headless runs)
+    void setOutput(ostream& stream) { out = &stream; }
+
+    void writeSnapshot(SnapshotWriter& out) {
+        if (!front) return;
+        Player* curr = front;
+        do {
+            PlayerRecord record = {};
+            record.playerID = curr->playerID;
+            record.rank = curr->rank;
+            record.username = out.intern(curr->username->text);
+            record.university = out.intern(curr->university->text);
+            record.registered = (int64_t)curr->registrationTime;
+            record.checkedIn = curr->checkInStatus;
+            record.isWildcard = curr->isWildcard;
+            record.inTournament = curr->inTournament;
+            out.addPlayer(record);
+            curr = curr->next;
+        } while (curr != front);
+    }
+
+    // Replace the queue with a snapshot. Records are already in tournament order
+    // with their admission flags, so nothing is parsed or re-sorted (unless the
+    // snapshot was written under a different seeding policy). The flags are
+    // recomputed if the capacity changed since the snapshot was written.
+    void loadSnapshot(const SnapshotView& snap) {
+        APUEC_TIME(Operation::LoadSnapshot);
+        clear();
+        size_t count = snap.playerCount();
+        pool.reserve(count);
+        vector<pair<SeedOrder, Player*>> sorted;
+        sorted.reserve(count);
+
+        for (size_t i = 0; i < count; ++i) {
+            const PlayerRecord& record = snap.player(i);
+            Player* p = pool.create(record.playerID, snap.str(record.username), record.rank,
+                                    snap.str(record.university), (time_t)record.registered,
+                                    record.isWildcard != 0, record.inTournament != 0);
+            p->checkInStatus = record.checkedIn != 0;
+            registrationClock.observe(p->registrationTime);
+            if (p->inTournament) lastAdmitted = p;
+            sorted.push_back(make_pair(keyOf(p), p));
+        }
+        observeID(snap.nextID() - 1);
+
+        auto byKey = [](const pair<SeedOrder, Player*>& a, const pair<SeedOrder, Player*>& b) {
+            return a.first < b.first;
+        };
+        bool inOrder = is_sorted(sorted.begin(), sorted.end(), byKey);
+        if (!inOrder) sort(sorted.begin(), sorted.end(), byKey);
+        trackSorted(sorted);
+
+        // The stored flags only hold for the order and capacity the snapshot was
+        // written with
+        size_t flagged = tournamentSet.count();
+        if (!inOrder || flagged != min(count, (size_t)capacity)) updateTournamentStatus();
+    }
+
+    // Returns the new player's ID
+    int enqueue(string username, int rank, string university, bool isWildcard = false) {
+        APUEC_TIME(Operation::Enqueue);
+        Player* newPlayer = pool.create(reserveIDs(), username, rank, university, registrationClock.now(), isWildcard, false);
+
+        link(newPlayer);
+        admitNewPlayer(newPlayer);
+        if (journal) {
+            journal->record('R', newPlayer->playerID, username, rank, university,
+                            (long long)newPlayer->registrationTime, isWildcard);
+        }
+        *out << "Player \"" << username << "\" registered with ID: " << newPlayer->playerID << endl;
+        return newPlayer->playerID;
     }
 
-public:
-    CircularQueue() : front(nullptr), rear(nullptr), nextID(1000), size(0) {}
+    // Register many players at once without console output. The batch shares one
+    // registration time and one journal commit, its nodes come from one pool block,
+    // and the new run is merged into the seeding order in a single pass over the
+    // ring (small batches into a large roster are spliced in one by one instead,
+    // which is cheaper than touching every node).
+    BatchResult enqueueBatch(const vector<Registration>& batch) {
+        APUEC_TIME(Operation::EnqueueBatch);
+        int unnumbered = 0;
+        for (const Registration& r : batch) unnumbered += r.playerID == 0;
+        BatchResult result = {reserveIDs(unnumbered), 0, 0, 0};
+        if (batch.empty()) return result;
 
-    void loadFromCSV(const string& filename) {
-        ifstream file(filename);
-        if (!file.is_open()) return;
+        // Players are created in ID order, as sortBatch expects; reserved IDs may
+        // arrive out of order
+        vector<pair<int, const Registration*>> numbered;
+        numbered.reserve(batch.size());
+        int assigned = result.firstID;
+        for (const Registration& r : batch) numbered.push_back(make_pair(r.playerID ? r.playerID : assigned++, &r));
+        auto byID = [](const pair<int, const Registration*>& a, const pair<int, const Registration*>& b) {
+            return a.first < b.first;
+        };
+        if (!is_sorted(numbered.begin(), numbered.end(), byID)) stable_sort(numbered.begin(), numbered.end(), byID);
 
-        string line;
-        while (getline(file, line)) {
-            stringstream ss(line);
-            string idStr, username, rankStr, university, checkInStr, timeStr, wildcardStr, inTournamentStr;
-            getline(ss, idStr, ',');
-            getline(ss, username, ',');
-            getline(ss, rankStr, ',');
-            getline(ss, university, ',');
-            getline(ss, checkInStr, ',');
-            getline(ss, timeStr, ',');
-            getline(ss, wildcardStr, ',');
-            getline(ss, inTournamentStr, ',');
-
-            Player* newPlayer = new Player(
-                stoi(idStr), username, stoi(rankStr), university, timeStr,
-                wildcardStr == "1", inTournamentStr == "1"
-            );
-            newPlayer->checkInStatus = (checkInStr == "1");
+        time_t now = registrationClock.now();
+        pool.reserve(batch.size());
+        vector<Player*> added;
+        added.reserve(batch.size());
+        for (size_t i = 0; i < numbered.size(); ++i) {
+            int id = numbered[i].first;
+            if ((i > 0 && id == numbered[i - 1].first) || index.find(id)) {
+                result.rejected++;
+                continue;
+            }
+            const Registration& r = *numbered[i].second;
+            observeID(id);
+            added.push_back(pool.create(id, r.username, r.rank, r.university, now, r.isWildcard, false));
+            added.back()->joining = true;
+        }
+        result.count = (int)added.size();
+        if (added.empty()) return result;
 
-            if (!front) {
-                front = rear = newPlayer;
-                newPlayer->next = newPlayer;
-            } else {
-                rear->next = newPlayer;
-                newPlayer->next = front;
-                rear = newPlayer;
+        size_t log2n = 1;
+        while ((size_t(1) << log2n) < (size_t)size + 1) log2n++;
+        if (added.size() * log2n < (size_t)size) {
+            for (Player* p : added) {
+                link(p);
+                admitNewPlayer(p);
             }
-            size++;
-            nextID = max(nextID, stoi(idStr) + 1);
+        } else {
+            Policy::sortBatch(added);
+            mergeSortedRun(added);
         }
-        file.close();
-    }
 
-    void saveAllToCSV(const string& filename) {
-        ofstream file(filename, ios::trunc);
-        if (!file.is_open() || !front) return;
-        Player* curr = front;
-        do {
-            file << curr->playerID << "," << curr->username << "," << curr->rank << ","
-                 << curr->university << "," << (curr->checkInStatus ? "1" : "0") << ","
-                 << curr->registrationTime << "," << (curr->isWildcard ? "1" : "0") << ","
-                 << (curr->inTournament ? "1" : "0") << "\n";
-            curr = curr->next;
-        } while (curr != front);
-        file.close();
+        for (Player* p : added) {
+            p->joining = false;
+            if (p->inTournament) result.admitted++;
+            if (journal) {
+                journal->record('R', p->playerID, p->username->text, p->rank, p->university->text,
+                                (long long)p->registrationTime, p->isWildcard);
+            }
+        }
+        if (journal) journal->commit();
+        return result;
     }
 
-    void enqueue(string username, int rank, string university, bool isWildcard = false) {
-        bool isInTournament = (size < maxSize);
-        Player* newPlayer = new Player(nextID++, username, rank, university, getCurrentTime(), isWildcard, isInTournament);
-
-        if (!front) {
-            front = rear = newPlayer;
-            newPlayer->next = newPlayer;
-        } else {
-            rear->next = newPlayer;
-            newPlayer->next = front;
-            rear = newPlayer;
-        }
-        size++;
-        cout << "Player \"" << username << "\" registered with ID: " << newPlayer->playerID << endl;
-        updateTournamentStatus();
+    // Batch-register every row of a file shaped like username,rank,university[,wildcard]
+    BatchResult enqueueBatchFromCSV(const string& filename) {
+        MappedFile file;
+        if (!file.open(filename)) return BatchResult{getNextID(), 0, 0, 0};
+        vector<Registration> batch = parseCsvFile<Registration>(file,
+            [](const string_view* f, int count, Registration& r) {
+                if (count < 3 || !parseInt(f[1], r.rank)) return false;
+                r.username = string(f[0]);
+                r.university = string(f[2]);
+                r.isWildcard = (count > 3 && f[3] == "1");
+                return true;
+            });
+        return enqueueBatch(batch);
     }
 
     void display() {
         if (!front) {
-            cout << "No players in queue.\n";
+            *out << "No players in queue.\n";
             return;
         }
-        Player* curr = front;
-        cout << "\n" << string(142, '=') << "\n";
-        cout << "| " << setw(6) << left << "ID"
-             << " | " << setw(20) << left << "Username"
-             << " | " << setw(6) << left << "Rank"
-             << " | " << setw(20) << left << "University"
-             << " | " << setw(19) << left << "Registered"
-             << " | " << setw(17) << left << "Status"
-             << " | " << setw(9) << left << "Wildcard"
-             << " | " << setw(20) << left << "Queue"
-             << " |\n";
-        cout << string(142, '-') << "\n";
+        display(PlayerView::All, 0, (size_t)-1);
+    }
+
+    // Number of players in view
+    size_t countOf(PlayerView view) const {
+        size_t admitted = min((size_t)size, (size_t)capacity);
+        if (view == PlayerView::Tournament) return admitted;
+        if (view == PlayerView::Waitlist) return (size_t)size - admitted;
+        return (size_t)size;
+    }
 
+    // List at most limit players of view, starting offset places into it (page N of
+    // size k is offset N * k). The first row is reached through the seeding order in
+    // O(log n), so only the rows shown are visited.
+    void display(PlayerView view, size_t offset, size_t limit, OutputFormat format = OutputFormat::Table) {
+        size_t first = (view == PlayerView::Waitlist) ? countOf(PlayerView::Tournament) : 0;
+        size_t available = countOf(view);
+        size_t rows = (offset < available) ? min(limit, available - offset) : 0;
+
+        TableRenderer table(*out, format, playerColumns, 8, playerTable);
+        table.header();
+        Player* curr = rows ? order.at(first + offset) : nullptr;
+        for (size_t i = 0; i < rows; ++i, curr = curr->next) renderPlayerRow(table, curr);
+        table.footer();
+    }
+
+    // List the players in a query result (see below), in seeding order
+    void display(const Bitmap& set, OutputFormat format = OutputFormat::Table) {
+        display(playersIn(set), format);
+    }
+
+    void display(const vector<const Player*>& players, OutputFormat format = OutputFormat::Table) {
+        TableRenderer table(*out, format, playerColumns, 8, playerTable);
+        table.header();
+        for (const Player* p : players) renderPlayerRow(table, p);
+        table.footer();
+    }
+
+    // Players whose username is exactly name (case-sensitive), in ID order. O(log n)
+    // to find the first match, then one step per match.
+    vector<const Player*> findByUsername(string_view name) const {
+        vector<const Player*> found;
+        byName.forEachFrom(NameKey{name, INT_MIN}, [&](const NameKey& key, Player* p) {
+            if (key.username != name) return false;
+            found.push_back(p);
+            return true;
+        });
+        return found;
+    }
+
+    // Up to limit players whose username starts with prefix, in name then ID order
+    vector<const Player*> searchUsername(string_view prefix, size_t limit = 50) const {
+        vector<const Player*> found;
+        byName.forEachFrom(NameKey{prefix, INT_MIN}, [&](const NameKey& key, Player* p) {
+            if (found.size() >= limit || key.username.substr(0, prefix.size()) != prefix) return false;
+            found.push_back(p);
+            return true;
+        });
+        return found;
+    }
+
+    // visit(const Player*) for every player, in seeding order
+    template <typename Visitor>
+    void forEachPlayer(Visitor visit) const {
+        if (!front) return;
+        const Player* curr = front;
         do {
-            cout << "| " << setw(6) << left << curr->playerID
-                 << " | " << setw(20) << left << curr->username
-                 << " | " << setw(6) << left << curr->rank
-                 << " | " << setw(20) << left << curr->university
-                 << " | " << setw(19) << left << curr->registrationTime
-                 << " | " << setw(17) << left << (curr->checkInStatus ? "Checked-In" : "Not Checked-In")
-                 << " | " << setw(9) << left << (curr->isWildcard ? "Yes" : "No")
-                 << " | " << setw(20) << left << (curr->inTournament ? "In Tournament" : "Waiting")
-                 << " |\n";
+            visit(curr);
             curr = curr->next;
         } while (curr != front);
-        cout << string(142, '=') << "\n";
+    }
+
+    // Rank statistics over the whole roster, each O(log n) plus the rows returned.
+    // Lower ranks are better; players with equal ranks are ordered by ID.
+
+    // The k best-ranked players, best first
+    vector<const Player*> topByRank(size_t k) const {
+        vector<const Player*> top;
+        byRank.forEachFrom(RankKey{INT_MIN, INT_MIN}, [&](const RankKey&, Player* p) {
+            if (top.size() >= k) return false;
+            top.push_back(p);
+            return true;
+        });
+        return top;
+    }
+
+    // Players whose rank is in [low, high]
+    size_t countRankBetween(int low, int high) const {
+        if (low > high) return 0;
+        size_t upTo = (high == INT_MAX) ? byRank.size() : byRank.countBelow(RankKey{high + 1, INT_MIN});
+        return upTo - byRank.countBelow(RankKey{low, INT_MIN});
+    }
+
+    // 1-based leaderboard position of a player, or 0 if there is no such player
+    size_t leaderboardPosition(int id) const {
+        const Player* p = index.find(id);
+        return p ? byRank.countBelow(RankKey{p->rank, id}) + 1 : 0;
+    }
+
+    // Percentile rank of a player: the share of the roster ranked below them, with
+    // players on the same rank counted as half
+    bool rankPercentile(int id, double& percentile) const {
+        const Player* p = index.find(id);
+        if (!p) return false;
+        size_t better = byRank.countBelow(RankKey{p->rank, INT_MIN});
+        size_t equal = countRankBetween(p->rank, p->rank);
+        size_t worse = (size_t)size - better - equal;
+        percentile = 100.0 * (worse + 0.5 * equal) / size;
+        return true;
+    }
+
+    // Bitmap queries. Each set holds player slots and they combine with & (AND),
+    // | (OR) and - (AND NOT, so NOT x is allPlayers() - x); count() is a popcount.
+    // Players from APU holding a slot who have not checked in:
+    //     (tournamentPlayers() & universityPlayers("APU")) - checkedInPlayers()
+    const Bitmap& allPlayers() const { return liveSet; }
+    const Bitmap& checkedInPlayers() const { return checkedInSet; }
+    const Bitmap& wildcardPlayers() const { return wildcardSet; }
+    const Bitmap& tournamentPlayers() const { return tournamentSet; }
+    Bitmap waitlistPlayers() const { return liveSet - tournamentSet; }
+
+    const Bitmap& universityPlayers(string_view university) const {
+        static const Bitmap none;
+        int interned = stringPool().idOf(university);
+        int at = interned >= 0 ? universitySet.find(interned) : 0;
+        return at ? universitySets[at - 1] : none;
+    }
+
+    vector<const Player*> playersIn(const Bitmap& set) const {
+        vector<const Player*> players;
+        players.reserve(set.count());
+        set.forEach([&](size_t slot) {
+            if (slot < slots.size() && slots[slot]) players.push_back(slots[slot]);
+        });
+        sort(players.begin(), players.end(),
+             [](const Player* a, const Player* b) { return keyOf(a) < keyOf(b); });
+        return players;
     }
 
     void checkIn(int id) {
         if (!front) return;
-        Player* curr = front;
-        do {
-            if (curr->playerID == id) {
-                curr->checkInStatus = true;
-                cout << "Player ID " << id << " checked in.\n";
-                return;
-            }
-            curr = curr->next;
-        } while (curr != front);
-        cout << "Player ID not found.\n";
+        if (!markCheckedIn(id)) {
+            *out << "Player ID not found.\n";
+            return;
+        }
+        *out << "Player ID " << id << " checked in.\n";
     }
 
     void withdraw(int id) {
         if (!front) return;
-        Player* curr = front;
-        Player* prev = rear;
-        do {
-            if (curr->playerID == id) {
-                if (curr == front && curr == rear) {
-                    delete curr;
-                    front = rear = nullptr;
-                } else if (curr == front) {
-                    front = front->next;
-                    rear->next = front;
-                    delete curr;
-                } else if (curr == rear) {
-                    prev->next = front;
-                    rear = prev;
-                    delete curr;
-                } else {
-                    prev->next = curr->next;
-                    delete curr;
-                }
-                cout << "Player ID " << id << " withdrawn.\n";
-                size--;
-                updateTournamentStatus();
-                return;
+        if (!remove(id)) {
+            *out << "Player ID not found.\n";
+            return;
+        }
+        *out << "Player ID " << id << " withdrawn.\n";
+    }
+
+    // Silent building blocks of the operations above; each one is journaled
+
+    bool markCheckedIn(int id) {
+        APUEC_TIME(Operation::CheckIn);
+        Player* curr = index.find(id);
+        if (!curr) return false;
+        curr->checkInStatus = true;
+        checkedInSet.setShared(curr->slot);
+        if (journal) journal->record('C', id);
+        return true;
+    }
+
+    bool remove(int id) {
+        APUEC_TIME(Operation::Withdraw);
+        Player* curr = index.find(id);
+        if (!curr) return false;
+        releaseSlot(curr);
+        unlink(curr);
+        pool.destroy(curr);
+        if (journal) journal->record('W', id);
+        return true;
+    }
+
+    bool updateInfo(int id, const string& username, int rank, const string& university) {
+        APUEC_TIME(Operation::EditInfo);
+        Player* curr = index.find(id);
+        if (!curr) return false;
+        StringRef newUniversity = stringPool().intern(university);
+        if (Policy::seedsByRank && rank != curr->rank) {
+            // A new seed: take the player out under the old key and put them back
+            // under the new one, keeping their ID, registration time and check-in
+            // Releasing the slot can promote the waitlist head and re-seating can
+            // push them straight back, so events are held and only net changes go out
+            vector<pair<Player*, bool>> changed;
+            changed.push_back(make_pair(curr, (bool)curr->inTournament));
+            held = &changed;
+            releaseSlot(curr);
+            unlink(curr);
+            curr->username = stringPool().intern(username);
+            curr->rank = rank;
+            curr->university = move(newUniversity);
+            link(curr);
+            admitNewPlayer(curr);
+            held = nullptr;
+            for (size_t i = 0; i < changed.size(); ++i) {
+                Player* p = changed[i].first;
+                bool seen = false;
+                for (size_t j = 0; j < i; ++j) seen = seen || changed[j].first == p;
+                if (!seen && p->inTournament != changed[i].second) notifyAdmission(p);
             }
-            prev = curr;
-            curr = curr->next;
-        } while (curr != front);
-        cout << "Player ID not found.\n";
+            if (journal) journal->record('E', id, username, rank, university);
+            return true;
+        }
+        if (newUniversity != curr->university) {
+            universityBits(curr->university).reset(curr->slot);
+            universityBits(newUniversity).set(curr->slot);
+        }
+        StringRef newUsername = stringPool().intern(username);
+        if (newUsername != curr->username) {
+            byName.erase(NameKey{curr->username->text, id});
+            byName.insert(NameKey{newUsername->text, id}, curr);
+        }
+        if (rank != curr->rank) {
+            byRank.erase(RankKey{curr->rank, id});
+            byRank.insert(RankKey{rank, id}, curr);
+        }
+        curr->username = move(newUsername);
+        curr->rank = rank;
+        curr->university = move(newUniversity);
+        if (journal) journal->record('E', id, username, rank, university);
+        return true;
     }
 
-    int getNextID() const { return nextID; }
+    // Re-create a player exactly as logged (ID and registration time included).
+    // Players that already exist are left alone so replay is idempotent.
+    bool restore(int id, const string& username, int rank, const string& university,
+                 time_t registered, bool isWildcard) {
+        if (index.find(id)) return false;
+        Player* newPlayer = pool.create(id, username, rank, university, registered, isWildcard, false);
+        link(newPlayer);
+        admitNewPlayer(newPlayer);
+        observeID(id);
+        registrationClock.observe(registered);
+        if (journal) journal->record('R', id, username, rank, university, (long long)registered, isWildcard);
+        return true;
+    }
 
-    bool exists(int id) {
-        if (!front) return false;
-        Player* curr = front;
-        do {
-            if (curr->playerID == id) return true;
-            curr = curr->next;
-        } while (curr != front);
+    // Apply one journal record (R, C, W or E); returns false for other record types
+    bool applyRecord(const string_view* f, int count) {
+        int id, rank;
+        long long registered;
+        switch (f[0].empty() ? 0 : f[0][0]) {
+        case 'R':
+            if (count < 7 || !parseInt(f[1], id) || !parseInt(f[3], rank)) return true;
+            registered = strtoll(string(f[5]).c_str(), nullptr, 10);
+            restore(id, string(f[2]), rank, string(f[4]), (time_t)registered, f[6] == "1");
+            return true;
+        case 'C':
+            if (count >= 2 && parseInt(f[1], id)) markCheckedIn(id);
+            return true;
+        case 'W':
+            if (count >= 2 && parseInt(f[1], id)) remove(id);
+            return true;
+        case 'E':
+            if (count >= 5 && parseInt(f[1], id) && parseInt(f[3], rank)) {
+                updateInfo(id, string(f[2]), rank, string(f[4]));
+            }
+            return true;
+        }
         return false;
     }
 
+    int getNextID() const { return nextID.load(memory_order_relaxed); }
+
+    // Take count consecutive IDs no one else will get, and return the first. Safe
+    // from any thread at any time, even while another thread is changing the queue,
+    // so an ID can be promised before the registration is applied (see
+    // RegistrationPipeline and Registration::playerID).
+    int reserveIDs(int count = 1) { return nextID.fetch_add(count, memory_order_relaxed); }
+
+    int getCapacity() const { return capacity; }
+
+    // Call listener for every promotion from the waitlist and every demotion to it,
+    // on the thread making the change (an empty function stops the reports)
+    void setAdmissionListener(function<void(const AdmissionEvent&)> listener) {
+        admissionListener = move(listener);
+    }
+
+    // Change the number of tournament slots. The boundary moves one player at a
+    // time, so this costs the number of players promoted or demoted.
+    void setCapacity(int slots) {
+        int admitted = min(size, capacity);
+        capacity = max(1, slots);
+        int target = min(size, capacity);
+        for (; admitted > target; --admitted) {
+            Player* last = lastAdmitted;
+            lastAdmitted = (admitted > 1) ? last->prev : nullptr;
+            setInTournament(last, false);
+        }
+        for (; admitted < target; ++admitted) {
+            Player* waiting = lastAdmitted ? lastAdmitted->next : front;
+            lastAdmitted = waiting;
+            setInTournament(waiting, true);
+        }
+    }
+
+    bool exists(int id) {
+        return index.find(id) != nullptr;
+    }
+
+    const Player* find(int id) const { return index.find(id); }
+
     void displayPlayer(int id) {
         if (!front) {
-            cout << "No players in queue.\n";
+            *out << "No players in queue.\n";
             return;
         }
-        Player* curr = front;
-        do {
-            if (curr->playerID == id) {
-                cout << "\n" << string(50, '=') << "\n";
-                cout << "Your Player Info\n";
-                cout << string(50, '=') << "\n";
-                cout << "ID           : " << curr->playerID << "\n";
-                cout << "Username     : " << curr->username << "\n";
-                cout << "Rank         : " << curr->rank << "\n";
-                cout << "University   : " << curr->university << "\n";
-                cout << "Registered   : " << curr->registrationTime << "\n";
-                cout << "Check-In     : " << (curr->checkInStatus ? "Checked-In" : "Not Checked-In") << "\n";
-                cout << "Wildcard     : " << (curr->isWildcard ? "Yes" : "No") << "\n";
-                cout << "Queue Status : " << (curr->inTournament ? "In Tournament" : "Waiting") << "\n";
-                cout << string(50, '=') << "\n";
-                return;
-            }
-            curr = curr->next;
-        } while (curr != front);
-        cout << "Player ID not found.\n";
+        Player* curr = index.find(id);
+        if (!curr) {
+            *out << "Player ID not found.\n";
+            return;
+        }
+        writePlayerInfo(*out, curr);
     }
 
     void editPlayerInfo(int id) {
         if (!front) return;
-        Player* curr = front;
-        do {
-            if (curr->playerID == id) {
-                string newUsername, newUniversity, rankStr;
-                int newRank;
-
-                cout << "\nEditing Your Info:\n";
-
-                // Edit username
-                while (true) {
-                    cout << "Enter new username (leave blank to keep \"" << curr->username << "\"): ";
-                    getline(cin, newUsername);
-                    if (newUsername.empty()) break;
-                    curr->username = newUsername;
-                    break;
-                }
+        Player* curr = index.find(id);
+        if (!curr) {
+            cout << "Player ID not found.\n";
+            return;
+        }
+        string newUsername = curr->username->text, newUniversity = curr->university->text;
+        int newRank = curr->rank;
+        promptForEdits(newUsername, newRank, newUniversity);
 
-                // Edit rank
-                while (true) {
-                    cout << "Enter new rank (current: " << curr->rank << "): ";
-                    getline(cin, rankStr);
-                    if (rankStr.empty()) break;
-                    bool valid = all_of(rankStr.begin(), rankStr.end(), ::isdigit);
-                    if (!valid) {
-                        cout << "Rank must be a number.\n";
-                        continue;
-                    }
-                    newRank = stoi(rankStr);
-                    curr->rank = newRank;
-                    break;
-                }
+        updateInfo(id, newUsername, newRank, newUniversity);
+        cout << "Info updated successfully.\n";
+    }
 
-                // Edit university
-                while (true) {
-                    cout << "Enter new university (leave blank to keep \"" << curr->university << "\"): ";
-                    getline(cin, newUniversity);
-                    if (newUniversity.empty()) break;
-                    curr->university = newUniversity;
-                    break;
-                }
+    // Ask for new values on cin; blank answers keep the values passed in
+    static void promptForEdits(string& newUsername, int& newRank, string& newUniversity) {
+        string input, rankStr;
 
-                cout << "Info updated successfully.\n";
-                return;
+        cout << "\nEditing Your Info:\n";
+
+        // Edit username
+        while (true) {
+            cout << "Enter new username (leave blank to keep \"" << newUsername << "\"): ";
+            getline(cin, input);
+            if (!input.empty()) newUsername = input;
+            break;
+        }
+
+        // Edit rank
+        while (true) {
+            cout << "Enter new rank (current: " << newRank << "): ";
+            getline(cin, rankStr);
+            if (rankStr.empty()) break;
+            bool valid = all_of(rankStr.begin(), rankStr.end(), ::isdigit);
+            if (!valid) {
+                cout << "Rank must be a number.\n";
+                continue;
             }
-            curr = curr->next;
-        } while (curr != front);
-        cout << "Player ID not found.\n";
+            newRank = stoi(rankStr);
+            break;
+        }
+
+        // Edit university
+        while (true) {
+            cout << "Enter new university (leave blank to keep \"" << newUniversity << "\"): ";
+            getline(cin, input);
+            if (!input.empty()) newUniversity = input;
+            break;
+        }
     }
 
+    // Recompute every inTournament flag from the seeding order. enqueue and
+    // withdraw keep the flags current incrementally; this is the full pass used
+    // after bulk loads.
     void updateTournamentStatus() {
+        APUEC_TIME(Operation::UpdateStatus);
+        lastAdmitted = nullptr;
         if (!front) return;
 
-        // Collect all players into an array
-        Player* playerList[200]; // assume max 200 players
-        int count = 0;
+        int position = 0;
         Player* curr = front;
-
         do {
-            playerList[count++] = curr;
+            setInTournament(curr, position < capacity); // top seeds get in
+            if (curr->inTournament) lastAdmitted = curr;
+            position++;
             curr = curr->next;
         } while (curr != front);
+    }
+};
 
-        // Time parser that cleans up \r or other trailing characters
-        auto parseTime = [](const string& timeStr) -> time_t {
-            struct tm t = {};
-            string cleanedTime = timeStr;
-            cleanedTime.erase(remove(cleanedTime.begin(), cleanedTime.end(), '\r'), cleanedTime.end());
-            istringstream ss(cleanedTime);
-            ss >> get_time(&t, "%Y-%m-%d %H:%M:%S");
-            if (ss.fail()) {
-                cout << "Failed to parse time: [" << timeStr << "]\n";
-                return time(0);
-            }
-            return mktime(&t);
-        };
-
-        // Sort players by wildcard priority, then registration time
-        for (int i = 0; i < count - 1; ++i) {
-            int minIndex = i;
-            for (int j = i + 1; j < count; ++j) {
-                bool aIsWildcard = playerList[j]->isWildcard;
-                bool bIsWildcard = playerList[minIndex]->isWildcard;
-
-                if (aIsWildcard && !bIsWildcard) {
-                    minIndex = j;
-                } else if (aIsWildcard == bIsWildcard) {
-                    time_t timeA = parseTime(playerList[j]->registrationTime);
-                    time_t timeB = parseTime(playerList[minIndex]->registrationTime);
-                    if (timeA < timeB) {
-                        minIndex = j;
-                    }
-                }
-            }
-            if (minIndex != i) {
-                Player* temp = playerList[i];
-                playerList[i] = playerList[minIndex];
-                playerList[minIndex] = temp;
-            }
-        }
-
-        // Update inTournament flags
-        for (int i = 0; i < count; ++i) {
-            playerList[i]->inTournament = (i < maxSize); // top 12 get in
-        }
+// The tournament queue: wildcards, then registration order, 12 slots
+typedef BasicCircularQueue<WildcardThenTime> CircularQueue;
 
-        // Rebuild circular linked list in new order
-        for (int i = 0; i < count - 1; ++i) {
-            playerList[i]->next = playerList[i + 1];
-        }
-        playerList[count - 1]->next = playerList[0];
+// Seeded by rank instead of registration time
+typedef BasicCircularQueue<RankSeeded> RankSeededQueue;
 
-        front = playerList[0];
-        rear = playerList[count - 1];
-    }
-};
 struct Wildcard {
     string code;
-    string username;
+    StringRef username;
     int rank;
-    string university;
+    StringRef university;
     bool used;
+    long long seq;      // insertion order, keeps equal ranks first-come first-served
     Wildcard* next;
+    Wildcard* prev;
+
+    Wildcard(string c, string_view u, int r, string_view uni, bool isUsed)
+        : code(c), username(stringPool().intern(u)), rank(r), university(stringPool().intern(uni)), used(isUsed), seq(0), next(nullptr), prev(nullptr) {}
+};
+
+// Wildcard list order: best (lowest) rank first, then insertion order
+struct WildcardKey {
+    int rank;
+    long long seq;
 
-    Wildcard(string c, string u, int r, string uni, bool isUsed)
-        : code(c), username(u), rank(r), university(uni), used(isUsed), next(nullptr) {}
+    bool operator<(const WildcardKey& other) const {
+        if (rank != other.rank) return rank < other.rank;
+        return seq < other.seq;
+    }
 };
 
 class WildcardQueue {
 private:
+    NodePool<Wildcard> pool;
     Wildcard* head = nullptr;
+    Journal* journal = nullptr;
+    HashIndex<string, Wildcard*> byCode;        // coupon code -> node
+    SkipList<WildcardKey, Wildcard*> byRank;    // rank order, mirrors the list
+    long long nextSeq = 0;
+    ostream* out = &cout;
+
+    // Splice a node into the list after prev (at the head if prev is null)
+    void linkAfter(Wildcard* prev, Wildcard* node) {
+        Wildcard* after = prev ? prev->next : head;
+        node->prev = prev;
+        node->next = after;
+        if (after) after->prev = node;
+        if (prev) {
+            prev->next = node;
+        } else {
+            head = node;
+        }
+    }
 
 public:
-    void loadFromCSV(const string& filename) {
-        ifstream file(filename);
-        if (!file.is_open()) return;
+    WildcardQueue() {}
+    ~WildcardQueue() { clear(); }
+
+    WildcardQueue(const WildcardQueue&) = delete;
+    WildcardQueue& operator=(const WildcardQueue&) = delete;
+
+    void clear() {
+        for (Wildcard* curr = head; curr; ) {
+            Wildcard* nextNode = curr->next;
+            curr->~Wildcard();
+            curr = nextNode;
+        }
+        pool.releaseAll();
+        byCode.clear();
+        byRank.clear();
+        head = nullptr;
+        nextSeq = 0;
+    }
+
+    bool contains(const string& code) const { return byCode.find(code) != nullptr; }
+
+    size_t size() const { return byCode.size(); }
 
-        string line;
-        while (getline(file, line)) {
-            stringstream ss(line);
-            string code, username, rankStr, university, usedStr;
-            getline(ss, code, ',');
-            getline(ss, username, ',');
-            getline(ss, rankStr, ',');
-            getline(ss, university, ',');
-            getline(ss, usedStr, ',');
+    size_t unusedCount() const {
+        size_t unused = 0;
+        for (Wildcard* curr = head; curr; curr = curr->next) unused += !curr->used;
+        return unused;
+    }
+
+    // One wildcard.csv row, viewing the mapped file: code,username,rank,university,used
+    struct WildcardRow {
+        string_view code, username, university;
+        int rank;
+        bool used;
+    };
+
+    static bool parseWildcardRow(const string_view* fields, int count, WildcardRow& row) {
+        string_view field[5];
+        for (int i = 0; i < count && i < 5; ++i) field[i] = fields[i];
+        if (!parseInt(field[2], row.rank)) return false;
+        row.code = field[0];
+        row.username = field[1];
+        row.university = field[3];
+        row.used = (field[4] == "1");
+        return true;
+    }
 
-            int rank = stoi(rankStr);
-            bool used = (usedStr == "1");
+    void loadFromCSV(const string& filename) {
+        APUEC_TIME(Operation::LoadCsv);
+        MappedFile file;
+        if (!file.open(filename)) return;
 
-            addWildcard(code, username, rank, university, used, false); // don't print
+        vector<WildcardRow> rows = parseCsvFile<WildcardRow>(file, parseWildcardRow);
+        for (const WildcardRow& row : rows) {
+            addWildcard(string(row.code), row.username, row.rank, row.university,
+                        row.used, false); // don't print
         }
-        file.close();
     }
 
-    void saveToCSV(const string& filename) {
-        ofstream file(filename, ios::trunc);
+    void writeCSV(ostream& file) {
+        APUEC_TIME(Operation::SaveCsv);
         Wildcard* curr = head;
         while (curr) {
-            file << curr->code << "," << curr->username << "," << curr->rank << ","
-                << curr->university << "," << (curr->used ? "1" : "0") << "\n";
+            file << curr->code << "," << curr->username->text << "," << curr->rank << ","
+                << curr->university->text << "," << (curr->used ? "1" : "0") << "\n";
             curr = curr->next;
         }
+    }
+
+    void saveToCSV(const string& filename) {
+        ofstream file(filename, ios::trunc);
+        writeCSV(file);
         file.close();
     }
 
-    void addWildcard(string code, string username, int rank, string university, bool used = false, bool showConfirm = true) {
-        Wildcard* newNode = new Wildcard(code, username, rank, university, used);
+    // Log every later change to journal (nullptr to stop logging)
+    void attachJournal(Journal* j) { journal = j; }
 
-        if (!head || rank < head->rank) {
-            newNode->next = head;
-            head = newNode;
-        } else {
-            Wildcard* curr = head;
-            while (curr->next && curr->next->rank <= rank) {
-                curr = curr->next;
+    // Send confirmations and listings to stream instead of cout (buffered/headless runs)
+    void setOutput(ostream& stream) { out = &stream; }
+
+    void writeSnapshot(SnapshotWriter& out) {
+        for (Wildcard* curr = head; curr; curr = curr->next) {
+            WildcardRecord record = {};
+            record.code = out.intern(curr->code);
+            record.username = out.intern(curr->username->text);
+            record.university = out.intern(curr->university->text);
+            record.rank = curr->rank;
+            record.used = curr->used;
+            out.addWildcard(record);
+        }
+    }
+
+    // Replace the list with a snapshot, which is already in rank order
+    void loadSnapshot(const SnapshotView& snap) {
+        APUEC_TIME(Operation::LoadSnapshot);
+        clear();
+        size_t count = snap.wildcardCount();
+        byCode.reserve(count);
+        vector<pair<WildcardKey, Wildcard*>> sorted;
+        sorted.reserve(count);
+        Wildcard* tail = nullptr;
+        for (size_t i = 0; i < count; ++i) {
+            const WildcardRecord& record = snap.wildcard(i);
+            Wildcard* node = pool.create(string(snap.str(record.code)), snap.str(record.username),
+                                         record.rank, snap.str(record.university), record.used != 0);
+            node->seq = nextSeq++;
+            linkAfter(tail, node);
+            tail = node;
+            byCode.insert(node->code, node);
+            sorted.push_back(make_pair(WildcardKey{node->rank, node->seq}, node));
+        }
+        byRank.assignSorted(sorted);
+    }
+
+    // Apply one journal record (A or X); returns false for other record types
+    bool applyRecord(const string_view* f, int count) {
+        string username, university;
+        int rank;
+        switch (f[0].empty() ? 0 : f[0][0]) {
+        case 'A':
+            if (count >= 6 && parseInt(f[3], rank)) {
+                addWildcard(string(f[1]), string(f[2]), rank, string(f[4]), f[5] == "1", false);
             }
-            newNode->next = curr->next;
-            curr->next = newNode;
+            return true;
+        case 'X':
+            if (count >= 2) redeemWildcard(string(f[1]), username, rank, university);
+            return true;
+        }
+        return false;
+    }
+
+    // Insert in rank order; returns false (and adds nothing) if the code already exists
+    bool addWildcard(string code, string_view username, int rank, string_view university, bool used = false, bool showConfirm = true) {
+        APUEC_TIME(Operation::AddWildcard);
+        if (contains(code)) {
+            if (showConfirm) *out << "Coupon code " << code << " already exists.\n";
+            return false;
         }
+        Wildcard* newNode = pool.create(code, username, rank, university, used);
+        newNode->seq = nextSeq++;
+        linkAfter(byRank.insert(WildcardKey{rank, newNode->seq}, newNode), newNode);
+        byCode.insert(code, newNode);
+        if (journal) journal->record('A', code, username, rank, university, used);
 
         if (showConfirm) {
-            cout << "Wildcard for " << username << " (Code: " << code << ") added.\n";
+            *out << "Wildcard for " << username << " (Code: " << code << ") added.\n";
         }
+        return true;
     }
 
     bool redeemWildcard(const string& code, string& username, int& rank, string& university) {
-        Wildcard* curr = head;
-        Wildcard* prev = nullptr;
+        APUEC_TIME(Operation::RedeemWildcard);
+        Wildcard* curr = byCode.find(code);
+        if (!curr || curr->used) return false;
 
-        while (curr) {
-            if (curr->code == code && !curr->used) {
-                // Extract info
-                username = curr->username;
-                rank = curr->rank;
-                university = curr->university;
-
-                // Remove the used node from the list
-                if (prev) {
-                    prev->next = curr->next;
-                } else {
-                    head = curr->next;
-                }
-                delete curr;
-                return true;
-            }
-            prev = curr;
-            curr = curr->next;
+        // Extract info
+        username = curr->username->text;
+        rank = curr->rank;
+        university = curr->university->text;
+
+        // Remove the used node from the list
+        if (curr->prev) {
+            curr->prev->next = curr->next;
+        } else {
+            head = curr->next;
         }
-        return false;
+        if (curr->next) curr->next->prev = curr->prev;
+        byRank.erase(WildcardKey{curr->rank, curr->seq});
+        byCode.erase(code);
+        pool.destroy(curr);
+        if (journal) journal->record('X', code);
+        return true;
     }
+
     void displayWildcards() {
         if (!head) {
-            cout << "No wildcard entries.\n";
+            *out << "No wildcard entries.\n";
             return;
         }
+        displayWildcards(0, (size_t)-1);
+    }
 
-        Wildcard* curr = head;
+    // List at most limit wildcards starting offset places into the rank order
+    void displayWildcards(size_t offset, size_t limit, OutputFormat format = OutputFormat::Table) {
+        static const Column columns[] = {
+            {"Coupon Code", "code", 12}, {"Username", "username", 20}, {"Rank", "rank", 6},
+            {"University", "university", 20}, {"Used", "used", 10}
+        };
+        TableRenderer table(*out, format, columns, 5, TableStyle{"| ", "| ", "|", 90});
+        table.header();
+        Wildcard* curr = byRank.at(offset);
+        for (size_t i = 0; curr && i < limit; ++i, curr = curr->next) {
+            table.cell(curr->code).cell(curr->username->text).cell(curr->rank).cell(curr->university->text)
+                 .cell(curr->used, "Yes", "No");
+            table.endRow();
+        }
+        table.footer();
+    }
+};
 
-        cout << "\n" << string(90, '=') << "\n";
-        cout << "| " << setw(12) << left << "Coupon Code"
-            << "| " << setw(20) << left << "Username"
-            << "| " << setw(6)  << left << "Rank"
-            << "| " << setw(20) << left << "University"
-            << "| " << setw(10) << left << "Used"
-            << "|\n";
-        cout << string(90, '-') << "\n";
+// Roster gauges followed by the operation metrics; shown by the admin menu and the
+// stats script command, and written to the stats file
+template <typename Queue>
+void writeStats(ostream& out, const Queue& queue, const WildcardQueue& wildcards) {
+    out << "Generated         : " << formatTime(time(0)) << "\n"
+        << "Players           : " << queue.countOf(PlayerView::All) << "\n"
+        << "In tournament     : " << queue.countOf(PlayerView::Tournament) << "\n"
+        << "Waitlist          : " << queue.countOf(PlayerView::Waitlist) << "\n"
+        << "Checked in        : " << queue.checkedInPlayers().count() << "\n"
+        << "Wildcard entrants : " << queue.wildcardPlayers().count() << "\n"
+        << "Wildcard codes    : " << wildcards.size() << " (" << wildcards.unusedCount() << " unused)\n\n";
+    writeMetrics(out);
+}
 
-        while (curr) {
-            cout << "| " << setw(12) << left << curr->code
-                << "| " << setw(20) << left << curr->username
-                << "| " << setw(6)  << left << curr->rank
-                << "| " << setw(20) << left << curr->university
-                << "| " << setw(10) << left << (curr->used ? "Yes" : "No")
-                << "|\n";
-            curr = curr->next;
+// Rewrites a stats file at most once per interval. tick() is cheap enough to call
+// after every operation; the first call writes straight away.
+class StatsFile {
+private:
+    string path;
+    chrono::steady_clock::duration interval;
+    chrono::steady_clock::time_point lastWrite;
+    bool written = false;
+    Persister* background = nullptr;
+
+public:
+    StatsFile(const string& filename, int intervalSeconds = 60)
+        : path(filename), interval(chrono::seconds(intervalSeconds)) {}
+
+    // Hand the writes to persister instead of doing them here (nullptr to stop)
+    void writeBehind(Persister* persister) { background = persister; }
+
+    template <typename Queue>
+    void tick(const Queue& queue, const WildcardQueue& wildcards) {
+        if (written && chrono::steady_clock::now() - lastWrite < interval) return;
+        write(queue, wildcards);
+    }
+
+    template <typename Queue>
+    bool write(const Queue& queue, const WildcardQueue& wildcards) {
+        ostringstream text;
+        writeStats(text, queue, wildcards);
+        lastWrite = chrono::steady_clock::now();
+        written = true;
+        if (background) {
+            background->writeLater(path, text.str());
+            return true;
+        }
+        return writeFileAtomically(path, text.str());
+    }
+};
+
+// Durable tournament state: the CSV files are the snapshot, and every change made
+// since the last snapshot is in an append-only journal. Startup loads the snapshot
+// and replays the journal; compaction folds the journal into a fresh snapshot on a
+// background thread. A binary copy of the snapshot (tournament.snap) is written next
+// to the CSVs and used instead of parsing them whenever it is present and valid.
+// With startWriteBehind() the journal is committed by a persister thread as well,
+// and no call made between operations waits on the disk.
+template <typename Queue>
+class BasicTournamentStore {
+private:
+    Queue& queue;
+    WildcardQueue& wildcards;
+    string playerFile, wildcardFile, journalFile, archiveFile, snapshotFile;
+    Journal journal;
+    thread compactor;
+    atomic<bool> compacting{false};
+    size_t compactThreshold;
+    unique_ptr<Persister> persister;    // after journal, so it stops first
+
+    size_t replayFile(const string& filename) {
+        size_t validBytes;
+        size_t applied = Journal::replay(filename, [&](const string_view* f, int count) {
+            if (!queue.applyRecord(f, count)) wildcards.applyRecord(f, count);
+        }, &validBytes);
+
+        // Cut off a torn tail so new records are never appended after garbage
+        MappedFile mapped;
+        if (mapped.open(filename) && validBytes < mapped.size()) {
+            string intact(mapped.begin(), validBytes);
+            mapped.close();
+            writeFileAtomically(filename, intact);
+        }
+        return applied;
+    }
+
+public:
+    BasicTournamentStore(Queue& q, WildcardQueue& w, const string& players, const string& wildcardCodes,
+                         const string& journalName = "tournament.journal", size_t compactBytes = 1 << 20,
+                         const string& snapshotName = "tournament.snap")
+        : queue(q), wildcards(w), playerFile(players), wildcardFile(wildcardCodes),
+          journalFile(journalName), archiveFile(journalName + ".old"), snapshotFile(snapshotName),
+          compactThreshold(compactBytes) {}
+
+    ~BasicTournamentStore() {
+        if (compactor.joinable()) compactor.join();
+        persister.reset();
+        queue.attachJournal(nullptr);
+        wildcards.attachJournal(nullptr);
+    }
+
+    // Load the snapshot, replay any journal left by a crash, then start logging.
+    // recordsPerCommit > 1 trades a bounded window of unsynced records for fewer fsyncs.
+    void recover(int recordsPerCommit = 1) {
+        SnapshotView snap;
+        if (snap.open(snapshotFile, playerFile, wildcardFile)) {
+            wildcards.loadSnapshot(snap);
+            queue.loadSnapshot(snap);
+        } else {
+            wildcards.loadFromCSV(wildcardFile);
+            queue.loadFromCSV(playerFile);
+        }
+
+        size_t replayed = replayFile(archiveFile) + replayFile(journalFile);
+
+        journal.open(journalFile, recordsPerCommit);
+        queue.attachJournal(&journal);
+        wildcards.attachJournal(&journal);
+        if (replayed > 0) compact(true);
+    }
+
+    // From here on, commit() only hands the journal to a persister thread, which
+    // makes it durable every interval or once dirtyRecords are waiting; that bounds
+    // what a crash can lose. Everything is flushed when the store goes away.
+    void startWriteBehind(chrono::milliseconds interval = chrono::milliseconds(200), size_t dirtyRecords = 64) {
+        if (persister) return;
+        journal.setGroupSize(INT_MAX);
+        persister.reset(new Persister(&journal, interval, dirtyRecords));
+    }
+
+    // The write-behind thread, for other files that should not be written in the
+    // foreground (nullptr until startWriteBehind)
+    Persister* writeBehind() { return persister.get(); }
+
+    // Group-commit boundary: make every logged operation durable, or with write-behind
+    // schedule it. Compaction starts once the journal is big enough and the previous
+    // one has finished.
+    void commit() {
+        if (persister) {
+            persister->noteDirty((size_t)journal.waiting());
+        } else {
+            APUEC_TIME(Operation::JournalCommit);
+            journal.commit();
+        }
+        if (journal.size() >= compactThreshold && !compacting) compact(false);
+    }
+
+    // Explicit save point: wait until every logged operation, and everything handed
+    // to the write-behind thread, is on disk
+    void flush() {
+        if (persister) {
+            persister->flush();
+        } else {
+            APUEC_TIME(Operation::JournalCommit);
+            journal.commit();
         }
+    }
 
-        cout << string(90, '=') << "\n";
+    // Fold the journal into a new snapshot. The state is serialized here; writing
+    // it out and dropping the archived journal happens on the compactor thread.
+    void compact(bool wait) {
+        APUEC_TIME(Operation::Compact);
+        if (compactor.joinable()) compactor.join();
+
+        ostringstream players, codes;
+        queue.writeCSV(players);
+        wildcards.writeCSV(codes);
+        SnapshotWriter snapshot;
+        queue.writeSnapshot(snapshot);
+        wildcards.writeSnapshot(snapshot);
+        // Only marks the split; the journal is moved into the archive on the
+        // compactor thread (or by whichever commit gets there first)
+        if (!journal.cut(archiveFile)) return;
+
+        string playerText = players.str(), codeText = codes.str();
+        string snapshotBytes = snapshot.finish(queue.getNextID());
+        string playerPath = playerFile, codePath = wildcardFile, archivePath = archiveFile, snapPath = snapshotFile;
+        Journal* log = &journal;
+        atomic<bool>* running = &compacting;
+        running->store(true);
+        compactor = thread([log, running, playerText, codeText, snapshotBytes, playerPath, codePath, archivePath,
+                            snapPath]() mutable {
+            log->commit();
+            if (log->cutCommitted()) {
+                if (!writeFileAtomically(playerPath, playerText) || !writeFileAtomically(codePath, codeText)) {
+                    remove(snapPath.c_str());
+                } else {
+                    remove(archivePath.c_str());
+                    if (!SnapshotWriter::seal(snapshotBytes, playerPath, codePath) ||
+                        !writeFileAtomically(snapPath, snapshotBytes)) {
+                        remove(snapPath.c_str());
+                    }
+                }
+            }
+            running->store(false);
+        });
+        if (wait) compactor.join();
     }
-};
\ No newline at end of file
+};
+
+typedef BasicTournamentStore<CircularQueue> TournamentStore;
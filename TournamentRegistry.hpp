@@ -0,0 +1,179 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "Task2.hpp"
+
+using namespace std;
+
+// One independent event: its own roster, capacity, wildcard pool and files
+// (<dir>/<name>.players.csv, .wildcards.csv, .journal and .snap)
+struct Tournament {
+    string name;
+    unsigned shard;
+    CircularQueue queue;
+    WildcardQueue wildcards;
+    TournamentStore store;
+
+    Tournament(const string& tournamentName, int capacity, const string& directory, unsigned shardIndex)
+        : name(tournamentName), shard(shardIndex), queue(capacity),
+          store(queue, wildcards, directory + "/" + tournamentName + ".players.csv",
+                directory + "/" + tournamentName + ".wildcards.csv",
+                directory + "/" + tournamentName + ".journal", 1 << 20,
+                directory + "/" + tournamentName + ".snap") {}
+};
+
+// A worker thread that runs posted tasks one at a time, in order
+class Shard {
+private:
+    mutex lock;
+    condition_variable wake;
+    deque<function<void()>> tasks;
+    bool stopping = false;
+    thread worker;      // last, so it starts after everything it uses
+
+    void loop() {
+        while (true) {
+            function<void()> task;
+            {
+                unique_lock<mutex> guard(lock);
+                wake.wait(guard, [this]() { return stopping || !tasks.empty(); });
+                if (tasks.empty()) return;
+                task = move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+public:
+    Shard() : worker([this]() { loop(); }) {}
+
+    // Finishes every task already posted, then stops
+    ~Shard() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+
+    Shard(const Shard&) = delete;
+    Shard& operator=(const Shard&) = delete;
+
+    void post(function<void()> task) {
+        {
+            lock_guard<mutex> guard(lock);
+            tasks.push_back(move(task));
+        }
+        wake.notify_one();
+    }
+};
+
+// Many tournaments in one process. Each tournament belongs to one shard and is only
+// ever touched by that shard's worker thread, so the queues need no locks and work
+// on tournaments in different shards never waits on each other. Tournaments are
+// added up front (from a manifest of name,capacity lines); after that the registry
+// itself is read-only and submit() can be called from any thread.
+class TournamentRegistry {
+private:
+    string directory;
+    vector<unique_ptr<Shard>> shards;
+    vector<unique_ptr<Tournament>> tournaments;
+    HashIndex<string, Tournament*> byName;
+
+    // Run f on every tournament, each on its own shard, and wait for all of them
+    template <typename F>
+    void forEachParallel(F f) {
+        vector<future<void>> pending;
+        for (auto& t : tournaments) pending.push_back(submit(t->name, f));
+        for (auto& done : pending) done.wait();
+    }
+
+public:
+    TournamentRegistry(const string& dir = ".", unsigned shardCount = 0) : directory(dir) {
+        if (shardCount == 0) shardCount = max(1u, thread::hardware_concurrency());
+        for (unsigned i = 0; i < shardCount; ++i) shards.push_back(unique_ptr<Shard>(new Shard()));
+    }
+
+    // Shards drain their queues before the tournaments they work on go away
+    ~TournamentRegistry() { shards.clear(); }
+
+    TournamentRegistry(const TournamentRegistry&) = delete;
+    TournamentRegistry& operator=(const TournamentRegistry&) = delete;
+
+    // Set-up only: not safe while tasks are running. Shards are dealt out in turn.
+    bool add(const string& name, int capacity) {
+        if (name.empty() || byName.find(name)) return false;
+        unsigned shard = (unsigned)(tournaments.size() % shards.size());
+        tournaments.push_back(unique_ptr<Tournament>(new Tournament(name, capacity, directory, shard)));
+        byName.insert(name, tournaments.back().get());
+        return true;
+    }
+
+    // Add every name,capacity row of a manifest file; returns how many were added
+    size_t loadManifest(const string& filename) {
+        MappedFile file;
+        if (!file.open(filename)) return 0;
+        struct Entry {
+            string_view name;
+            int capacity;
+        };
+        vector<Entry> entries = parseCsvFile<Entry>(file, [](const string_view* f, int count, Entry& e) {
+            if (count < 2 || !parseInt(f[1], e.capacity) || e.capacity < 1) return false;
+            e.name = f[0];
+            return true;
+        });
+        size_t added = 0;
+        for (const Entry& e : entries) added += add(string(e.name), e.capacity);
+        return added;
+    }
+
+    bool saveManifest(const string& filename) const {
+        ostringstream text;
+        for (const auto& t : tournaments) text << t->name << "," << t->queue.getCapacity() << "\n";
+        return writeFileAtomically(filename, text.str());
+    }
+
+    size_t size() const { return tournaments.size(); }
+    size_t shardCount() const { return shards.size(); }
+
+    vector<string> names() const {
+        vector<string> result;
+        for (const auto& t : tournaments) result.push_back(t->name);
+        return result;
+    }
+
+    // Run f(Tournament&) on the tournament's shard. The future carries f's result;
+    // it is not valid() if there is no tournament with that name.
+    template <typename F>
+    auto submit(const string& name, F f) -> future<decltype(f(declval<Tournament&>()))> {
+        typedef decltype(f(declval<Tournament&>())) Result;
+        Tournament* t = byName.find(name);
+        if (!t) return future<Result>();
+        auto task = make_shared<packaged_task<Result()>>([t, f]() mutable { return f(*t); });
+        future<Result> result = task->get_future();
+        shards[t->shard]->post([task]() { (*task)(); });
+        return result;
+    }
+
+    // Load every tournament from its own files, all shards in parallel
+    void recoverAll(int recordsPerCommit = 1) {
+        forEachParallel([recordsPerCommit](Tournament& t) { t.store.recover(recordsPerCommit); });
+    }
+
+    void commitAll() {
+        forEachParallel([](Tournament& t) { t.store.commit(); });
+    }
+
+    // Write every tournament's snapshot and CSV files, all shards in parallel
+    void compactAll() {
+        forEachParallel([](Tournament& t) { t.store.compact(true); });
+    }
+};
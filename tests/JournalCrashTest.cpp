@@ -0,0 +1,270 @@
+// Crash/replay tests for the journal and TournamentStore recovery. A crash is
+// simulated by copying the files as they are at that moment into a fresh
+// directory and recovering from the copy; whatever was not on disk yet is lost,
+// exactly as if the process had died there. Damaged snapshots must be refused.
+
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Check.hpp"
+#include "Task2.hpp"
+
+using namespace std;
+
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+static const string Root = "journal_crash";
+
+// Start an empty directory under Root
+static string freshDir(const string& name) {
+    string dir = Root + "/" + name;
+    filesystem::remove_all(dir);
+    filesystem::create_directories(dir);
+    return dir;
+}
+
+static void crashCopy(const string& from, const string& to) {
+    freshDir(to.substr(Root.size() + 1));
+    for (const auto& entry : filesystem::directory_iterator(from)) {
+        filesystem::copy_file(entry.path(), to + "/" + entry.path().filename().string());
+    }
+}
+
+static string readFile(const string& filename) {
+    ifstream in(filename, ios::binary);
+    ostringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+// Second field of every intact record in filename, in order
+static vector<string> replayed(const string& filename) {
+    vector<string> ids;
+    Journal::replay(filename, [&](const string_view* f, int count) {
+        CHECK(count == 2);
+        ids.push_back(string(f[1]));
+    });
+    return ids;
+}
+
+// cut() only marks the split: a crash before the next commit must leave exactly the
+// records committed before the cut, with no archive yet
+static void cutThenCrash() {
+    string dir = freshDir("cut");
+    string path = dir + "/j", archive = dir + "/j.old";
+    Journal journal;
+    CHECK(journal.open(path));
+    journal.setGroupSize(INT_MAX);
+    journal.record('X', 1);
+    journal.record('X', 2);
+    CHECK(journal.commit());
+    journal.record('X', 3);            // logged, not committed
+    CHECK(journal.cut(archive));
+    CHECK(!journal.cut(archive));      // the first cut is not committed yet
+    journal.record('X', 4);
+
+    crashCopy(dir, Root + "/cut.crash");
+    CHECK(!fileExists(Root + "/cut.crash/j.old"));
+    CHECK(replayed(Root + "/cut.crash/j") == vector<string>({"1", "2"}));
+
+    // The commit finishes the cut: everything before it in the archive, the rest
+    // in a new journal
+    CHECK(journal.commit());
+    CHECK(journal.cutCommitted());
+    crashCopy(dir, Root + "/cut.crash");
+    CHECK(replayed(Root + "/cut.crash/j.old") == vector<string>({"1", "2", "3"}));
+    CHECK(replayed(Root + "/cut.crash/j") == vector<string>({"4"}));
+}
+
+// If the archive is still there from a compaction that never finished, the next
+// cut appends to it instead of replacing it
+static void existingArchive() {
+    string dir = freshDir("append");
+    string path = dir + "/j", archive = dir + "/j.old";
+    {
+        Journal journal;
+        CHECK(journal.open(path));
+        journal.record('X', 1);
+        journal.record('X', 2);
+        CHECK(journal.rotate(archive));
+    }
+    CHECK(replayed(archive) == vector<string>({"1", "2"}));
+
+    Journal journal;
+    CHECK(journal.open(path));
+    journal.setGroupSize(INT_MAX);
+    journal.record('X', 3);
+    CHECK(journal.commit());
+    journal.record('X', 4);
+    CHECK(journal.cut(archive));
+    journal.record('X', 5);
+    crashCopy(dir, Root + "/append.crash");
+    CHECK(replayed(Root + "/append.crash/j.old") == vector<string>({"1", "2"}));
+    CHECK(replayed(Root + "/append.crash/j") == vector<string>({"3"}));
+
+    CHECK(journal.commit());
+    CHECK(journal.cutCommitted());
+    CHECK(replayed(archive) == vector<string>({"1", "2", "3", "4"}));
+    CHECK(replayed(path) == vector<string>({"5"}));
+
+    // and the new journal keeps going after the append
+    journal.record('X', 6);
+    CHECK(journal.commit());
+    CHECK(replayed(path) == vector<string>({"5", "6"}));
+}
+
+// A store over dir, recovered from whatever files are there
+struct Recovered {
+    NullBuffer nothing;
+    ostream sink{&nothing};
+    CircularQueue queue;
+    WildcardQueue wildcards;
+    TournamentStore store;
+
+    Recovered(const string& dir, int recordsPerCommit = 1)
+        : queue(8),
+          store(queue, wildcards, dir + "/player.csv", dir + "/wildcard.csv", dir + "/t.journal", 1 << 20,
+                dir + "/t.snap") {
+        queue.setOutput(sink);
+        wildcards.setOutput(sink);
+        store.recover(recordsPerCommit);
+    }
+
+    string roster() {
+        ostringstream csv;
+        queue.writeCSV(csv);
+        return csv.str();
+    }
+};
+
+static void play(Recovered& r, int from, int count) {
+    for (int i = from; i < from + count; ++i) {
+        r.queue.enqueue("p" + to_string(i), 1 + i % 10, "APU", i % 9 == 0);
+        if (i % 3 == 0) r.queue.checkIn(i / 2 + 1);
+        if (i % 5 == 0) r.queue.withdraw(i / 3 + 1);
+    }
+}
+
+// Byte offset just past the record in the middle of a journal file
+static size_t middleRecord(const string& text) {
+    size_t at = text.find('\n', text.size() / 2);
+    CHECK(at != string::npos);
+    return at + 1;
+}
+
+static void storeRecovery() {
+    string dir = freshDir("store");
+    string expected;
+    {
+        Recovered live(dir, INT_MAX);
+        play(live, 0, 300);
+        live.store.commit();
+        expected = live.roster();
+        play(live, 300, 50);           // never committed: lost in the crash
+        CHECK(live.roster() != expected);
+        crashCopy(dir, Root + "/store.crash");
+    }
+    string crashed = Root + "/store.crash";
+    string journal = readFile(crashed + "/t.journal");
+    {
+        Recovered after(crashed);
+        CHECK(after.roster() == expected);
+    }
+
+    // The journal split into an archive and a new journal, as a crash after the
+    // compactor's commit but before it wrote the CSVs leaves it; the torn record at
+    // the end was being written when the process died
+    string split = Root + "/store.split";
+    freshDir("store.split");
+    size_t middle = middleRecord(journal);
+    CHECK(writeFileAtomically(split + "/t.journal.old", journal.substr(0, middle)));
+    CHECK(writeFileAtomically(split + "/t.journal", journal.substr(middle) + "R,9999,torn"));
+    {
+        // Replays both, drops the torn tail, then compacts with the archive still
+        // there, so the journal is appended to it before the CSVs are written
+        Recovered after(split);
+        CHECK(after.roster() == expected);
+        CHECK(readFile(split + "/t.journal").find("torn") == string::npos);
+    }
+    CHECK(!fileExists(split + "/t.journal.old"));
+    CHECK(fileExists(split + "/t.snap"));
+    {
+        Recovered again(split);
+        CHECK(again.roster() == expected);
+    }
+
+    // Crash with the archive appended but the old journal not yet removed: replaying
+    // the same records twice must still end in the same roster
+    string twice = Root + "/store.twice";
+    freshDir("store.twice");
+    CHECK(writeFileAtomically(twice + "/t.journal.old", journal));
+    CHECK(writeFileAtomically(twice + "/t.journal", journal.substr(middle)));
+    {
+        Recovered after(twice);
+        CHECK(after.roster() == expected);
+    }
+}
+
+// A snapshot with a valid checksum but a string outside its string table (as a
+// faulty writer could leave) is refused, and recovery falls back to the CSVs
+static void snapshotStringBounds() {
+    string dir = freshDir("snap");
+    string expected;
+    {
+        Recovered live(dir);
+        play(live, 0, 40);
+        live.store.compact(true);
+        expected = live.roster();
+    }
+    string snap = dir + "/t.snap";
+    string bytes = readFile(snap);
+    SnapshotHeader header;
+    memcpy(&header, bytes.data(), sizeof(header));
+    CHECK(header.playerCount > 0);
+    {
+        SnapshotView intact;
+        CHECK(intact.open(snap, dir + "/player.csv", dir + "/wildcard.csv"));
+    }
+
+    size_t lastPlayer = sizeof(SnapshotHeader) + (header.playerCount - 1) * sizeof(PlayerRecord);
+    size_t table = bytes.size() - header.stringBytes;
+    uint32_t huge = 0xFFFFFFF0u;
+    vector<pair<size_t, uint32_t>> breaks = {
+        {lastPlayer + offsetof(PlayerRecord, university), header.stringBytes},      // past the end
+        {lastPlayer + offsetof(PlayerRecord, username), header.stringBytes - 2},    // length cut off
+        {lastPlayer + offsetof(PlayerRecord, university), UINT32_MAX - 1},          // wraps around
+        {table, huge},                                                              // first length too long
+    };
+    for (auto& damage : breaks) {
+        string broken = bytes;
+        memcpy(&broken[damage.first], &damage.second, sizeof(uint32_t));
+        SnapshotHeader stamped = header;
+        stamped.checksum = 0;
+        memcpy(&broken[0], &stamped, sizeof(stamped));
+        stamped.checksum = snapshotChecksum(broken.data(), broken.size());
+        memcpy(&broken[0], &stamped, sizeof(stamped));
+        CHECK(writeFileAtomically(snap, broken));
+
+        SnapshotView view;
+        CHECK(!view.open(snap, dir + "/player.csv", dir + "/wildcard.csv"));
+        Recovered after(dir);
+        CHECK(after.roster() == expected);
+    }
+}
+
+int main() {
+    filesystem::remove_all(Root);
+    cutThenCrash();
+    existingArchive();
+    storeRecovery();
+    snapshotStringBounds();
+    filesystem::remove_all(Root);
+    return 0;
+}
@@ -0,0 +1,182 @@
+// Tests for the write-behind Persister and TournamentStore::startWriteBehind: the
+// journal reaches the disk once enough records are waiting or the interval has
+// passed, files handed over several times between rounds are written once, and
+// everything handed over is on disk after flush() or when the persister or the
+// store goes away.
+
+#include <chrono>
+#include <climits>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "Check.hpp"
+#include "Task2.hpp"
+
+using namespace std;
+
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+static const string Root = "persister_data";
+static const chrono::hours Never(1);    // an interval no test waits for
+
+static string freshDir(const string& name) {
+    string dir = Root + "/" + name;
+    filesystem::remove_all(dir);
+    filesystem::create_directories(dir);
+    return dir;
+}
+
+static string readFile(const string& filename) {
+    ifstream in(filename, ios::binary);
+    ostringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+static size_t onDisk(const string& journal) {
+    return Journal::replay(journal, [](const string_view*, int) {});
+}
+
+// Poll until done() holds; false if it still does not after limit
+template <typename Done>
+static bool within(chrono::milliseconds limit, Done done) {
+    auto deadline = chrono::steady_clock::now() + limit;
+    while (!done()) {
+        if (chrono::steady_clock::now() > deadline) return false;
+        this_thread::sleep_for(chrono::milliseconds(2));
+    }
+    return true;
+}
+
+// Nothing is committed below the threshold; reaching it commits without waiting
+// for the interval
+static void dirtyThreshold() {
+    string path = freshDir("threshold") + "/j";
+    Journal journal;
+    CHECK(journal.open(path));
+    journal.setGroupSize(INT_MAX);
+    Persister persister(&journal, Never, 4);
+    for (int i = 1; i <= 3; ++i) journal.record('X', i);
+    persister.noteDirty(3);
+    this_thread::sleep_for(chrono::milliseconds(100));
+    CHECK(onDisk(path) == 0);
+
+    journal.record('X', 4);
+    persister.noteDirty(4);
+    CHECK(within(chrono::seconds(5), [&]() { return onDisk(path) == 4; }));
+}
+
+// Below the threshold, the interval alone gets records and files to disk
+static void interval() {
+    string dir = freshDir("interval");
+    Journal journal;
+    CHECK(journal.open(dir + "/j"));
+    journal.setGroupSize(INT_MAX);
+    Persister persister(&journal, chrono::milliseconds(50), 1000);
+    journal.record('X', 1);
+    persister.noteDirty(1);
+    persister.writeLater(dir + "/stats", "first");
+    CHECK(within(chrono::seconds(5), [&]() { return onDisk(dir + "/j") == 1 && readFile(dir + "/stats") == "first"; }));
+}
+
+// A file handed over many times between rounds is written once, with the last
+// contents; flush() waits for exactly that
+static void coalescing() {
+    string dir = freshDir("coalesce");
+    Persister persister(nullptr, Never, 1000);
+    for (int i = 0; i < 10; ++i) persister.writeLater(dir + "/a", "a" + to_string(i));
+    persister.writeLater(dir + "/b", "b");
+    this_thread::sleep_for(chrono::milliseconds(50));
+    CHECK(persister.filesWritten() == 0 && !fileExists(dir + "/a"));
+
+    persister.flush();
+    CHECK(persister.filesWritten() == 2);
+    CHECK(readFile(dir + "/a") == "a9" && readFile(dir + "/b") == "b");
+
+    persister.writeLater(dir + "/a", "again");
+    persister.flush();
+    CHECK(persister.filesWritten() == 3 && readFile(dir + "/a") == "again");
+}
+
+// The destructor writes out whatever is still waiting, however long the interval
+static void destructorFlushes() {
+    string dir = freshDir("destroy");
+    Journal journal;
+    CHECK(journal.open(dir + "/j"));
+    journal.setGroupSize(INT_MAX);
+    {
+        Persister persister(&journal, Never, 1000);
+        for (int i = 0; i < 20; ++i) journal.record('X', i);
+        persister.noteDirty(20);
+        persister.writeLater(dir + "/stats", "old");
+        persister.writeLater(dir + "/stats", "latest");
+        CHECK(onDisk(dir + "/j") == 0);
+    }
+    CHECK(onDisk(dir + "/j") == 20);
+    CHECK(readFile(dir + "/stats") == "latest");
+}
+
+// The same through a store: commits are handed to the persister, flush() is a save
+// point, and the state recovered after the store goes away is the last one
+static void storeWriteBehind() {
+    string dir = freshDir("store");
+    string expected;
+    NullBuffer nothing;
+    ostream sink(&nothing);
+    {
+        CircularQueue queue(8);
+        WildcardQueue wildcards;
+        queue.setOutput(sink);
+        wildcards.setOutput(sink);
+        TournamentStore store(queue, wildcards, dir + "/player.csv", dir + "/wildcard.csv", dir + "/t.journal",
+                              1 << 20, dir + "/t.snap");
+        store.recover();
+        store.startWriteBehind(Never, 10);
+        for (int i = 0; i < 9; ++i) {
+            queue.enqueue("p" + to_string(i), 1 + i, "APU");
+            store.commit();
+        }
+        this_thread::sleep_for(chrono::milliseconds(50));
+        CHECK(onDisk(dir + "/t.journal") == 0);
+        queue.enqueue("p9", 10, "APU");
+        store.commit();
+        CHECK(within(chrono::seconds(5), [&]() { return onDisk(dir + "/t.journal") == 10; }));
+
+        queue.checkIn(1003);
+        queue.withdraw(1005);
+        store.commit();
+        this_thread::sleep_for(chrono::milliseconds(50));
+        CHECK(onDisk(dir + "/t.journal") == 10);
+        store.flush();
+        CHECK(onDisk(dir + "/t.journal") == 12);
+        ostringstream csv;
+        queue.writeCSV(csv);
+        expected = csv.str();
+    }
+
+    CircularQueue queue(8);
+    WildcardQueue wildcards;
+    queue.setOutput(sink);
+    wildcards.setOutput(sink);
+    TournamentStore store(queue, wildcards, dir + "/player.csv", dir + "/wildcard.csv", dir + "/t.journal",
+                          1 << 20, dir + "/t.snap");
+    store.recover();
+    ostringstream csv;
+    queue.writeCSV(csv);
+    CHECK(csv.str() == expected);
+}
+
+int main() {
+    filesystem::remove_all(Root);
+    dirtyThreshold();
+    interval();
+    coalescing();
+    destructorFlushes();
+    storeWriteBehind();
+    filesystem::remove_all(Root);
+    return 0;
+}
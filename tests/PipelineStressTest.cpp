@@ -0,0 +1,155 @@
+// Stress test for MpscRing and RegistrationPipeline; run it under TSan
+// (-DAPUEC_SANITIZE=thread) to check the ring's memory ordering as well.
+
+#include <string>
+#include <thread>
+#include <vector>
+#include "Check.hpp"
+#include "RegistrationPipeline.hpp"
+
+using namespace std;
+
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+// Producers wrap a small ring many times while the consumer drains it. Every value
+// must come out exactly once, in ticket order.
+static void ringStress() {
+    const int Producers = 4;
+    const uint64_t PerProducer = 50000;
+    MpscRing<uint64_t> ring(64);
+    vector<vector<uint64_t>> tickets(Producers, vector<uint64_t>(PerProducer));
+
+    vector<uint64_t> drained;
+    drained.reserve(Producers * PerProducer);
+    thread consumer([&]() {
+        while (drained.size() < Producers * PerProducer) {
+            if (ring.drain(drained, 100) == 0) this_thread::yield();
+        }
+    });
+    vector<thread> producers;
+    for (int p = 0; p < Producers; ++p) {
+        producers.emplace_back([&, p]() {
+            for (uint64_t i = 0; i < PerProducer; ++i) tickets[p][i] = ring.push(((uint64_t)p << 32) | i);
+        });
+    }
+    for (auto& t : producers) t.join();
+    consumer.join();
+
+    CHECK(ring.claimed() == Producers * PerProducer);
+    CHECK(drained.size() == Producers * PerProducer);
+    for (int p = 0; p < Producers; ++p) {
+        for (uint64_t i = 0; i < PerProducer; ++i) {
+            uint64_t ticket = tickets[p][i];
+            CHECK(ticket < drained.size());
+            CHECK(drained[ticket] == (((uint64_t)p << 32) | i));
+            if (i > 0) CHECK(ticket > tickets[p][i - 1]);
+        }
+    }
+}
+
+// Several desks register through one pipeline, and one directly on the queue,
+// while readers take snapshots. Every returned ID must end up as that player, with
+// no gaps or duplicates.
+static void pipelineStress() {
+    const int Desks = 4;
+    const int PerDesk = 3000;
+    const int Direct = 500;
+    NullBuffer nothing;
+    ostream sink(&nothing);
+    ConcurrentCircularQueue queue;
+    queue.write([&](CircularQueue& q) { q.setOutput(sink); });
+    queue.enqueue("seed", 1, "APU");
+    int firstID = queue.getNextID();
+    vector<vector<int>> ids(Desks + 1);
+    atomic<bool> done{false};
+    {
+        RegistrationPipeline pipeline(queue, 256, 64);
+        thread reader([&]() {
+            size_t last = 0;
+            while (!done.load()) {
+                auto roster = queue.snapshot();
+                CHECK(roster.size() >= last);   // registrations are only ever added
+                last = roster.size();
+                size_t seen = 0;
+                roster.forEach([&](const PlayerVersion&) { return ++seen > 0; });
+                CHECK(seen == roster.size());
+            }
+        });
+        vector<thread> desks;
+        for (int d = 0; d < Desks; ++d) {
+            desks.emplace_back([&, d]() {
+                for (int i = 0; i < PerDesk; ++i) {
+                    string name = "desk" + to_string(d) + "_" + to_string(i);
+                    ids[d].push_back(pipeline.enqueue(name, 1 + i % 10, "APU", i % 50 == 0));
+                }
+            });
+        }
+        desks.emplace_back([&]() {
+            for (int i = 0; i < Direct; ++i) ids[Desks].push_back(queue.enqueue("direct" + to_string(i), 1 + i % 10, "UM"));
+        });
+        for (auto& t : desks) t.join();
+        pipeline.flush();
+        CHECK(pipeline.pending() == 0 && pipeline.rejected() == 0);
+        done.store(true);
+        reader.join();
+    }
+
+    const int Total = Desks * PerDesk + Direct;
+    CHECK(queue.getNextID() == firstID + Total);
+    vector<bool> issued(Total, false);
+    queue.read([&](const CircularQueue& q) {
+        CHECK(q.countOf(PlayerView::All) == (size_t)(1 + Total));
+        for (int d = 0; d <= Desks; ++d) {
+            for (size_t i = 0; i < ids[d].size(); ++i) {
+                int id = ids[d][i];
+                CHECK(id >= firstID && id < firstID + Total);
+                CHECK(!issued[id - firstID]);
+                issued[id - firstID] = true;
+                const Player* p = q.find(id);
+                string name = d < Desks ? "desk" + to_string(d) + "_" + to_string(i) : "direct" + to_string(i);
+                CHECK(p && p->username->text == name);
+            }
+        }
+        return 0;
+    });
+}
+
+// Registrations that bring an ID reserved earlier keep it, in any order; one whose
+// ID is already taken is rejected and nothing else changes
+static void reservedIDs() {
+    NullBuffer nothing;
+    ostream sink(&nothing);
+    ConcurrentCircularQueue queue;
+    queue.write([&](CircularQueue& q) { q.setOutput(sink); });
+    int taken = queue.enqueue("first", 5, "APU");
+    int a = queue.reserveIDs(), b = queue.reserveIDs(2);
+    CHECK(b == a + 1 && queue.getNextID() == a + 3);
+
+    vector<Registration> batch = {Registration{"b2", 3, "APU", false, b + 1}, Registration{"auto", 2, "APU", false},
+                                  Registration{"a", 1, "APU", true, a}, Registration{"dup", 4, "APU", false, taken},
+                                  Registration{"b", 6, "APU", false, b}, Registration{"again", 7, "APU", false, a}};
+    BatchResult result = queue.enqueueBatch(batch);
+    CHECK(result.count == 4 && result.rejected == 2 && result.firstID == a + 3);
+    CHECK(queue.getNextID() == a + 4);
+    queue.read([&](const CircularQueue& q) {
+        CHECK(q.countOf(PlayerView::All) == 5);
+        CHECK(q.find(taken)->username->text == "first");
+        CHECK(q.find(a)->username->text == "a" && q.find(a)->isWildcard);
+        CHECK(q.find(b)->username->text == "b" && q.find(b + 1)->username->text == "b2");
+        CHECK(q.find(a + 3)->username->text == "auto");
+        return 0;
+    });
+    PlayerVersion record;
+    CHECK(queue.snapshot().find(b + 1, record) && record.rank == 3);
+    CHECK(queue.enqueue("next", 1, "APU") == a + 4);
+}
+
+int main() {
+    ringStress();
+    pipelineStress();
+    reservedIDs();
+    return 0;
+}
@@ -0,0 +1,132 @@
+// Tests for BasicCircularQueue<RankSeeded>: players are seeded wildcards first, then
+// by rank, and the top capacity hold the slots. updateInfo with a new rank takes the
+// player out and seats them again, and only net slot changes are reported.
+
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Check.hpp"
+#include "Task2.hpp"
+
+using namespace std;
+
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+static vector<int> order(const RankSeededQueue& q) {
+    vector<int> ids;
+    q.forEachPlayer([&](const Player* p) { ids.push_back(p->playerID); });
+    return ids;
+}
+
+// The ring must be in key order with exactly the first capacity players admitted
+static void checkSeeding(const RankSeededQueue& q) {
+    vector<const Player*> ring;
+    q.forEachPlayer([&](const Player* p) { ring.push_back(p); });
+    vector<const Player*> sorted = ring;
+    sort(sorted.begin(), sorted.end(), [](const Player* a, const Player* b) {
+        return RankSeeded::keyOf(a) < RankSeeded::keyOf(b);
+    });
+    CHECK(ring == sorted);
+    size_t slots = min(ring.size(), (size_t)q.getCapacity());
+    for (size_t i = 0; i < ring.size(); ++i) CHECK(ring[i]->inTournament == (i < slots));
+    CHECK(q.countOf(PlayerView::Tournament) == slots);
+}
+
+static void admissionAndReseating() {
+    NullBuffer nothing;
+    ostream sink(&nothing);
+    RankSeededQueue q(3);
+    q.setOutput(sink);
+    int a = q.enqueue("a", 5, "APU");
+    int b = q.enqueue("b", 3, "APU");
+    int c = q.enqueue("c", 8, "APU");
+    int d = q.enqueue("d", 1, "APU");
+    CHECK(order(q) == vector<int>({d, b, a, c}));
+    CHECK(q.find(a)->inTournament && !q.find(c)->inTournament);
+
+    // A wildcard is seeded above every rank, whatever their own
+    int w = q.enqueue("w", 9, "APU", true);
+    CHECK(order(q) == vector<int>({w, d, b, a, c}));
+    CHECK(!q.find(a)->inTournament);
+    checkSeeding(q);
+
+    typedef vector<pair<int, AdmissionEvent::Kind>> Events;
+    Events events;
+    q.setAdmissionListener([&](const AdmissionEvent& e) { events.push_back(make_pair(e.playerID, e.kind)); });
+
+    // Up from the waitlist past a slot holder: c in, b out
+    q.markCheckedIn(c);
+    time_t registered = q.find(c)->registrationTime;
+    CHECK(q.updateInfo(c, "c", 2, "APU"));
+    CHECK(order(q) == vector<int>({w, d, c, b, a}));
+    CHECK((events == Events{{c, AdmissionEvent::Promoted}, {b, AdmissionEvent::Demoted}}));
+    const Player* moved = q.find(c);
+    CHECK(moved->playerID == c && moved->registrationTime == registered && moved->checkInStatus);
+    checkSeeding(q);
+
+    // Down from a slot: d out, the waitlist head (b) in
+    events.clear();
+    CHECK(q.updateInfo(d, "d", 10, "APU"));
+    CHECK(order(q) == vector<int>({w, c, b, a, d}));
+    CHECK((events == Events{{d, AdmissionEvent::Demoted}, {b, AdmissionEvent::Promoted}}));
+    checkSeeding(q);
+
+    // A new rank that keeps the player on the same side of the line moves them
+    // without reporting anything
+    events.clear();
+    CHECK(q.updateInfo(b, "b", 1, "APU"));
+    CHECK(q.updateInfo(a, "a", 11, "UM"));
+    CHECK(order(q) == vector<int>({w, b, c, d, a}));
+    CHECK(events.empty());
+    CHECK(q.find(a)->university->text == "UM");
+    checkSeeding(q);
+
+    // A batch is seeded among everyone already there
+    vector<Registration> batch = {Registration{"x", 4, "APU", false}, Registration{"y", 2, "APU", false},
+                                  Registration{"z", 0, "APU", false}};
+    BatchResult result = q.enqueueBatch(batch);
+    int x = result.firstID, y = x + 1, z = x + 2;
+    CHECK(order(q) == vector<int>({w, z, b, c, y, x, d, a}));
+    checkSeeding(q);
+}
+
+// Random registrations, batches, rank changes and withdrawals against the order
+static void randomized() {
+    NullBuffer nothing;
+    ostream sink(&nothing);
+    RankSeededQueue q(16);
+    q.setOutput(sink);
+    mt19937 rng(2025);
+    for (int step = 0; step < 4000; ++step) {
+        int op = (int)(rng() % 10);
+        int next = q.getNextID();
+        if (op < 3) {
+            q.enqueue("p" + to_string(step), 1 + (int)(rng() % 20), "APU", rng() % 15 == 0);
+        } else if (op < 4) {
+            vector<Registration> batch;
+            for (int i = 0; i < 1 + (int)(rng() % 30); ++i) {
+                batch.push_back(Registration{"b" + to_string(step) + "_" + to_string(i), 1 + (int)(rng() % 20), "UM",
+                                             rng() % 15 == 0});
+            }
+            q.enqueueBatch(batch);
+        } else if (op < 8) {
+            int id = 1000 + (int)(rng() % (unsigned)(next - 1000 + 1));
+            if (const Player* p = q.find(id)) q.updateInfo(id, p->username->text, 1 + (int)(rng() % 20), "MMU");
+        } else {
+            q.withdraw(1000 + (int)(rng() % (unsigned)(next - 1000 + 1)));
+        }
+        if (step % 50 == 0) checkSeeding(q);
+    }
+    checkSeeding(q);
+}
+
+int main() {
+    admissionAndReseating();
+    randomized();
+    return 0;
+}
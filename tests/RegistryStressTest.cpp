@@ -0,0 +1,129 @@
+// Stress test for TournamentRegistry: client threads submit registrations,
+// check-ins and withdrawals to tournaments spread over a few shards. Each
+// tournament must only ever run on its own shard, end up with exactly the players
+// its tasks left behind, and recover to the same roster from its files. Run it
+// under TSan (-DAPUEC_SANITIZE=thread) as well, since the shards share the string
+// pool and the metrics.
+
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Check.hpp"
+#include "TournamentRegistry.hpp"
+
+using namespace std;
+
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+struct Model {
+    set<int> live;
+    thread::id runsOn;
+    bool started = false;
+};
+
+static string rosterOf(Tournament& t) {
+    ostringstream csv;
+    t.queue.writeCSV(csv);
+    return csv.str();
+}
+
+int main() {
+    const string directory = "registry_data";
+    filesystem::remove_all(directory);
+    filesystem::create_directory(directory);
+
+    const int Tournaments = 6;
+    const int Clients = 4;
+    const int PerClient = 2000;
+    NullBuffer nothing;
+    vector<unique_ptr<ostream>> sinks;  // one per tournament, used on its shard only
+    vector<Model> models(Tournaments);
+    vector<string> names;
+    vector<string> rosters(Tournaments);
+
+    {
+        TournamentRegistry registry(directory, 3);
+        for (int i = 0; i < Tournaments; ++i) {
+            names.push_back("cup" + to_string(i));
+            CHECK(registry.add(names.back(), 8 + i));
+            sinks.push_back(unique_ptr<ostream>(new ostream(&nothing)));
+        }
+        CHECK(!registry.add("cup0", 4));
+        CHECK(!registry.submit("missing", [](Tournament&) { return 0; }).valid());
+        for (int i = 0; i < Tournaments; ++i) {
+            ostream* sink = sinks[i].get();
+            registry.submit(names[i], [sink](Tournament& t) { t.queue.setOutput(*sink); }).wait();
+        }
+        registry.recoverAll();
+
+        vector<thread> clients;
+        for (int c = 0; c < Clients; ++c) {
+            clients.emplace_back([&, c]() {
+                mt19937 rng(300 + c);
+                vector<future<void>> pending;
+                for (int step = 0; step < PerClient; ++step) {
+                    int which = (int)(rng() % Tournaments);
+                    int op = (int)(rng() % 10);
+                    int pick = (int)rng();
+                    Model* model = &models[which];
+                    pending.push_back(registry.submit(names[which], [model, op, pick, c, step](Tournament& t) {
+                        // Tasks for one tournament always run on the same thread
+                        if (!model->started) {
+                            model->runsOn = this_thread::get_id();
+                            model->started = true;
+                        }
+                        CHECK(model->runsOn == this_thread::get_id());
+                        int next = t.queue.getNextID();
+                        if (op < 6 || model->live.empty()) {
+                            t.queue.enqueue("c" + to_string(c) + "_" + to_string(step), 1 + pick % 10, "APU");
+                            model->live.insert(next);
+                        } else if (op < 8) {
+                            int id = 1 + (int)((unsigned)pick % (unsigned)next);
+                            t.queue.checkIn(id);
+                        } else {
+                            int id = 1 + (int)((unsigned)pick % (unsigned)next);
+                            t.queue.withdraw(id);
+                            model->live.erase(id);
+                        }
+                        t.store.commit();
+                    }));
+                }
+                for (auto& done : pending) done.wait();
+            });
+        }
+        for (auto& t : clients) t.join();
+        registry.commitAll();
+
+        for (int i = 0; i < Tournaments; ++i) {
+            Model* model = &models[i];
+            string* roster = &rosters[i];
+            registry.submit(names[i], [model, roster](Tournament& t) {
+                set<int> ids;
+                t.queue.forEachPlayer([&](const Player* p) { ids.insert(p->playerID); });
+                CHECK(ids == model->live);
+                *roster = rosterOf(t);
+            }).wait();
+        }
+        CHECK(registry.saveManifest(directory + "/manifest.csv"));
+    }
+
+    // Same rosters back from the files, half of them through a compaction
+    TournamentRegistry registry(directory, 2);
+    CHECK(registry.loadManifest(directory + "/manifest.csv") == (size_t)Tournaments);
+    registry.recoverAll();
+    registry.compactAll();
+    for (int i = 0; i < Tournaments; ++i) {
+        string* roster = &rosters[i];
+        CHECK(registry.submit(names[i], [roster](Tournament& t) { return rosterOf(t) == *roster; }).get());
+    }
+    filesystem::remove_all(directory);
+    return 0;
+}
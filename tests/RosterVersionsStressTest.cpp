@@ -0,0 +1,228 @@
+// Stress test for RosterVersions behind ConcurrentCircularQueue: writers register,
+// check in, withdraw and reseed while readers pin versions and hold them across
+// many writes. Then check-in latency is measured with and without a long export
+// holding a version. Run it under TSan (-DAPUEC_SANITIZE=thread) as well.
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Check.hpp"
+#include "ConcurrentCircularQueue.hpp"
+
+using namespace std;
+
+// Swallows the queue's messages without any shared stream state
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+struct Seen {
+    int playerID;
+    int rank;
+    bool checkInStatus;
+    bool inTournament;
+};
+
+// A held version reads back the same, except that check-ins made since show up
+static bool sameButCheckIns(const vector<Seen>& later, const vector<Seen>& earlier) {
+    if (later.size() != earlier.size()) return false;
+    for (size_t i = 0; i < later.size(); ++i) {
+        const Seen& a = later[i];
+        const Seen& b = earlier[i];
+        if (a.playerID != b.playerID || a.rank != b.rank || a.inTournament != b.inTournament ||
+            a.checkInStatus < b.checkInStatus) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static vector<Seen> contents(const ConcurrentCircularQueue::Versions::View& roster) {
+    vector<Seen> result;
+    roster.forEach([&](const PlayerVersion& p) {
+        result.push_back(Seen{p.playerID, p.rank, p.checkInStatus, p.inTournament});
+        return true;
+    });
+    return result;
+}
+
+// A version must hold its players in seeding order with the admitted ones first
+static void checkVersion(const ConcurrentCircularQueue::Versions::View& roster, const vector<Seen>& seen) {
+    CHECK(seen.size() == roster.size());
+    size_t admitted = 0;
+    while (admitted < seen.size() && seen[admitted].inTournament) admitted++;
+    CHECK(admitted == roster.countOf(PlayerView::Tournament));
+    for (size_t i = admitted; i < seen.size(); ++i) CHECK(!seen[i].inTournament);
+}
+
+static void stress() {
+    NullBuffer nothing;
+    ostream sink(&nothing);
+    ConcurrentCircularQueue queue;
+    queue.write([&](CircularQueue& q) { q.setOutput(sink); });
+    for (int i = 0; i < 200; ++i) queue.enqueue("base" + to_string(i), 1 + i % 10, "APU", i % 7 == 0);
+
+    atomic<bool> done{false};
+    atomic<int> writersLeft{2};
+
+    // Writers: one registers, withdraws and reseeds; one registers in batches and
+    // recomputes the standings. Both hold the writer lock, so they share the sink.
+    vector<thread> threads;
+    for (int w = 0; w < 2; ++w) {
+        threads.emplace_back([&, w]() {
+            mt19937 rng(100 + w);
+            for (int step = 0; step < 1500; ++step) {
+                int next = queue.getNextID();
+                int op = (int)(rng() % 10);
+                if (w == 0 && op < 5) {
+                    queue.enqueue("w" + to_string(step), 1 + (int)(rng() % 10), "UM", rng() % 20 == 0);
+                } else if (w == 0 && op < 9) {
+                    queue.withdraw(1 + (int)(rng() % next));
+                } else if (w == 0) {
+                    queue.write([&](CircularQueue& q) {
+                        int id = 1 + (int)(rng() % next);
+                        if (const Player* p = q.find(id)) q.updateInfo(id, p->username->text, 1 + (int)(rng() % 10), "MMU");
+                    });
+                } else if (op < 7) {
+                    vector<Registration> batch;
+                    for (int i = 0; i < 1 + (int)(rng() % 20); ++i) {
+                        batch.push_back(Registration{"b" + to_string(step) + "_" + to_string(i), 1 + (int)(rng() % 10), "USM", false});
+                    }
+                    queue.enqueueBatch(batch);
+                } else {
+                    queue.updateTournamentStatus();
+                }
+            }
+            writersLeft--;
+        });
+    }
+
+    // Check-in desks: no lock at all
+    for (int d = 0; d < 2; ++d) {
+        threads.emplace_back([&, d]() {
+            mt19937 rng(7 + d);
+            while (writersLeft.load() > 0) queue.markCheckedIn(1 + (int)(rng() % queue.getNextID()));
+        });
+    }
+
+    // Readers: every pinned version must stay exactly as it was while writers go on
+    for (int r = 0; r < 3; ++r) {
+        threads.emplace_back([&, r]() {
+            mt19937 rng(1000 + r);
+            while (!done.load()) {
+                vector<ConcurrentCircularQueue::Versions::View> held;
+                vector<vector<Seen>> first;
+                for (int i = 0; i < 4; ++i) {
+                    held.push_back(queue.snapshot());
+                    first.push_back(contents(held.back()));
+                    checkVersion(held.back(), first.back());
+                    if (i > 0) CHECK(held[i].version() >= held[i - 1].version());
+                    this_thread::yield();
+                }
+                for (size_t i = 0; i < held.size(); ++i) CHECK(sameButCheckIns(contents(held[i]), first[i]));
+                queue.exists(1 + (int)(rng() % queue.getNextID()));
+            }
+        });
+    }
+
+    while (writersLeft.load() > 0) this_thread::sleep_for(chrono::milliseconds(5));
+    done.store(true);
+    for (auto& t : threads) t.join();
+
+    // With the writers gone, the published version must match the live queue
+    ostringstream published, live;
+    queue.writeCSV(published);
+    vector<int> ids;
+    queue.write([&](CircularQueue& q) {
+        q.writeCSV(live);
+        q.forEachPlayer([&](const Player* p) { ids.push_back(p->playerID); });
+    });
+    CHECK(published.str() == live.str());
+    for (int id : ids) {
+        PlayerVersion record;
+        CHECK(queue.snapshot().find(id, record) && record.playerID == id);
+        CHECK(queue.read([&](const CircularQueue& q) {
+            const Player* p = q.find(id);
+            return p->rank == record.rank && p->username == record.username &&
+                   (bool)p->checkInStatus == record.checkInStatus && p->inTournament == record.inTournament;
+        }));
+    }
+    CHECK(!queue.exists(-1) && !queue.exists(queue.getNextID()));
+}
+
+// Time count first check-ins starting at player first, in nanoseconds each
+static vector<long long> timeCheckIns(ConcurrentCircularQueue& queue, int first, int count) {
+    vector<long long> samples;
+    for (int id = first; id < first + count; ++id) {
+        auto start = chrono::steady_clock::now();
+        CHECK(queue.markCheckedIn(id));
+        samples.push_back(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count());
+    }
+    sort(samples.begin(), samples.end());
+    return samples;
+}
+
+// A long export holding a pinned version must not slow check-ins down
+static void checkInLatency() {
+    const int Players = 20000, Sample = 5000;
+    ConcurrentCircularQueue queue;
+    int first = queue.getNextID();
+    vector<Registration> batch;
+    for (int i = 0; i < Players; ++i) batch.push_back(Registration{"lat" + to_string(i), 1 + i % 10, "APU", false});
+    queue.enqueueBatch(batch);
+
+    vector<long long> quiet = timeCheckIns(queue, first, Sample);
+
+    // Walks a pinned version slowly, a thousand rows at a time, until told to stop
+    atomic<bool> stop{false}, pinned{false};
+    thread exporter([&]() {
+        while (!stop.load()) {
+            auto roster = queue.snapshot();
+            pinned.store(true);
+            size_t rows = 0;
+            ostringstream csv;
+            roster.forEach([&](const PlayerVersion& p) {
+                writePlayerCsvRow(csv, &p);
+                if (++rows % 1000 == 0) this_thread::sleep_for(chrono::microseconds(500));
+                return !stop.load();
+            });
+        }
+    });
+    while (!pinned.load()) this_thread::yield();
+    vector<long long> exporting = timeCheckIns(queue, first + Sample, Sample);
+    stop.store(true);
+    exporter.join();
+
+    long long quietMedian = quiet[Sample / 2], exportMedian = exporting[Sample / 2];
+    printf("check-in latency  quiet: p50 %lld ns, p99 %lld ns   during export: p50 %lld ns, p99 %lld ns\n",
+           quietMedian, quiet[Sample * 99 / 100], exportMedian, exporting[Sample * 99 / 100]);
+    CHECK(exportMedian <= 4 * quietMedian + 20000);
+
+    // Every check-in is visible at once, and in the live queue after the next write
+    auto roster = queue.snapshot();
+    for (int id = first; id < first + 2 * Sample; ++id) {
+        PlayerVersion record;
+        CHECK(roster.find(id, record) && record.checkInStatus);
+    }
+    queue.updateTournamentStatus();
+    CHECK(queue.read([&](const CircularQueue& q) {
+        for (int id = first; id < first + Players; ++id) {
+            if ((bool)q.find(id)->checkInStatus != (id < first + 2 * Sample)) return false;
+        }
+        return true;
+    }));
+}
+
+int main() {
+    // Every name the run interned is freed with the last player and version holding it
+    size_t interned = stringPool().size();
+    stress();
+    CHECK(stringPool().size() == interned);
+    checkInLatency();
+    return 0;
+}
@@ -0,0 +1,88 @@
+// Randomized model check of the span-augmented SkipList against a sorted vector:
+// every operation is applied to both and the answers must agree, including the
+// position queries (at, countBelow) that depend on the spans being right.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "Check.hpp"
+#include "Task2.hpp"
+
+using namespace std;
+
+// Values are never 0, so Value() still means "none"
+static int valueOf(int key) { return key * 3 + 1; }
+
+static void checkSame(const SkipList<int, int>& list, const vector<int>& model) {
+    CHECK(list.size() == model.size());
+    size_t i = 0;
+    list.forEach([&](int key, int value) {
+        CHECK(i < model.size() && key == model[i] && value == valueOf(key));
+        i++;
+    });
+    CHECK(i == model.size());
+}
+
+int main() {
+    mt19937 rng(20251017);
+    const int KeyRange = 2000;
+    SkipList<int, int> list;
+    vector<int> model;
+
+    for (int step = 0; step < 300000; ++step) {
+        int op = (int)(rng() % 100);
+        int key = (int)(rng() % KeyRange);
+        auto found = lower_bound(model.begin(), model.end(), key);
+        bool present = found != model.end() && *found == key;
+
+        if (op < 35) {
+            if (present) continue;  // keys are unique
+            int before = found == model.begin() ? 0 : valueOf(*(found - 1));
+            CHECK(list.insert(key, valueOf(key)) == before);
+            model.insert(found, key);
+        } else if (op < 60) {
+            CHECK(list.erase(key) == present);
+            if (present) model.erase(found);
+        } else if (op < 80) {
+            size_t position = rng() % (model.size() + 3);
+            int expected = position < model.size() ? valueOf(model[position]) : 0;
+            CHECK(list.at(position) == expected);
+        } else if (op < 95) {
+            CHECK(list.countBelow(key) == (size_t)(found - model.begin()));
+        } else if (op < 99) {
+            vector<int> seen;
+            list.forEachFrom(key, [&](int k, int) {
+                seen.push_back(k);
+                return seen.size() < 5;
+            });
+            vector<int> expected(found, min(found + 5, model.end()));
+            CHECK(seen == expected);
+            CHECK(list.first() == (model.empty() ? 0 : valueOf(model[0])));
+        } else {
+            // Rebuild from a fresh sorted set; later inserts and erases must still
+            // keep the spans consistent
+            model.clear();
+            size_t n = rng() % 3000;
+            for (size_t i = 0; i < n; ++i) model.push_back((int)(rng() % KeyRange));
+            sort(model.begin(), model.end());
+            model.erase(unique(model.begin(), model.end()), model.end());
+            vector<pair<int, int>> entries;
+            for (int k : model) entries.push_back(make_pair(k, valueOf(k)));
+            list.assignSorted(entries);
+        }
+        if (step % 1000 == 0) checkSame(list, model);
+    }
+    checkSame(list, model);
+
+    // Every position of a large bulk-built list
+    vector<pair<int, int>> entries;
+    for (int k = 0; k < 100000; ++k) entries.push_back(make_pair(k * 2, valueOf(k * 2)));
+    list.assignSorted(entries);
+    for (int k = 0; k < 100000; ++k) {
+        CHECK(list.at(k) == valueOf(k * 2));
+        CHECK(list.countBelow(k * 2 + 1) == (size_t)k + 1);
+    }
+    list.clear();
+    CHECK(list.size() == 0 && list.at(0) == 0 && list.first() == 0);
+    return 0;
+}